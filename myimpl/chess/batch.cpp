@@ -0,0 +1,182 @@
+#include "chess.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    SearchLimits limits;
+    int mateDepth = 0;
+    int workers = 1;
+    std::string input;
+    std::string output;
+};
+
+// EPD lines may carry an id operation; it is echoed back to match results
+// up with the source file.
+std::string epdId(const std::string& line) {
+    std::size_t pos = line.find(" id \"");
+    if (pos == std::string::npos) return "";
+    pos += 5;
+    std::size_t end = line.find('"', pos);
+    return line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string analyzeLine(chessboard& board, const std::string& line, std::size_t index, const Options& opt) {
+    std::ostringstream out;
+    out << "{\"index\":" << index;
+    std::string id = epdId(line);
+    if (!id.empty()) out << ",\"id\":" << jsonString(id);
+
+    bool whiteToMove = true;
+    if (!board.loadFEN(line, whiteToMove)) {
+        out << ",\"error\":\"invalid fen\"}";
+        return out.str();
+    }
+    out << ",\"fen\":" << jsonString(board.toFEN(whiteToMove));
+
+    // Which worker gets a position varies from run to run, so nothing the
+    // previous position left in the table may carry over. A new generation
+    // hides it without clearing the whole table per line; iterativeDeepening
+    // starts from empty killers and history itself.
+    board.newHashGeneration();
+    SearchResult r = board.iterativeDeepening(whiteToMove, opt.limits);
+    out << ",\"bestmove\":" << (r.hasMove ? jsonString(moveToString(r.bestMove)) : "null")
+        << ",\"score\":" << r.score;
+    if (chessboard::isMateScore(r.score)) {
+        int moves = (chessboard::matePlies(r.score) + 1) / 2;
+        out << ",\"mate\":" << (r.score > 0 ? moves : -moves);
+    }
+    out << ",\"depth\":" << r.depth << ",\"nodes\":" << r.nodes << ",\"time_ms\":" << r.timeMs;
+
+    // The mate pass gets the same per-position time and node limit as the
+    // search; mate_plies is null when it runs out before an answer.
+    if (opt.mateDepth > 0) {
+        std::vector<Move> sequence;
+        int plies = board.findMate(opt.mateDepth, whiteToMove, sequence, MateSearchMode::ALL_MOVES, opt.limits);
+        out << ",\"mate_plies\":" << (plies == chessboard::MATE_UNKNOWN ? "null" : std::to_string(plies)) << ",\"mate_line\":[";
+        for (std::size_t i = 0; i < sequence.size(); ++i) {
+            out << (i ? "," : "") << jsonString(moveToString(sequence[i]));
+        }
+        out << "]";
+    }
+    out << "}";
+    return out.str();
+}
+
+void usage() {
+    std::cerr << "usage: batch <file> [--depth n] [--movetime ms] [--nodes n] [--mate plies]\n"
+              << "             [--workers n] [-o out.jsonl]\n"
+              << "One FEN or EPD position per line. Writes one JSON object per line in\n"
+              << "input order; score is white-relative centipawns. --movetime and --nodes\n"
+              << "also bound the --mate pass of each position.\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    opt.limits.maxDepth = 0;
+    opt.workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--depth" && hasValue) opt.limits.maxDepth = std::atoi(argv[++i]);
+        else if (a == "--movetime" && hasValue) opt.limits.timeMs = std::atoi(argv[++i]);
+        else if (a == "--nodes" && hasValue) opt.limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--mate" && hasValue) opt.mateDepth = std::atoi(argv[++i]);
+        else if (a == "--workers" && hasValue) opt.workers = std::max(1, std::atoi(argv[++i]));
+        else if (a == "-o" && hasValue) opt.output = argv[++i];
+        else if (a[0] != '-' && opt.input.empty()) opt.input = a;
+        else return false;
+    }
+
+    // Without any limit a search would run to MAX_PLY; default to depth 6.
+    if (opt.limits.maxDepth <= 0) {
+        opt.limits.maxDepth = (opt.limits.timeMs || opt.limits.nodes) ? SearchLimits{}.maxDepth : 6;
+    }
+    return !opt.input.empty();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+
+    std::ifstream in(opt.input);
+    if (!in) {
+        std::cerr << "cannot open " << opt.input << std::endl;
+        return 1;
+    }
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && line[0] != '#') lines.push_back(line);
+    }
+
+    std::ofstream file;
+    if (!opt.output.empty()) file.open(opt.output);
+    std::ostream& out = opt.output.empty() ? std::cout : file;
+
+    // Workers pull the next index and park their result; the main thread
+    // writes results out as soon as the next one in input order is ready.
+    std::vector<std::string> results(lines.size());
+    std::vector<char> done(lines.size(), 0);
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable ready;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    const int workerCount = static_cast<int>(std::min<std::size_t>(opt.workers, std::max<std::size_t>(lines.size(), 1)));
+    for (int w = 0; w < workerCount; ++w) {
+        workers.emplace_back([&]() {
+            chessboard board;
+            for (std::size_t i = next++; i < lines.size(); i = next++) {
+                std::string result = analyzeLine(board, lines[i], i, opt);
+                std::lock_guard<std::mutex> lock(mutex);
+                results[i] = std::move(result);
+                done[i] = 1;
+                ready.notify_one();
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&]() { return done[i] != 0; });
+        std::string result = std::move(results[i]);
+        lock.unlock();
+        out << result << '\n';
+    }
+    out.flush();
+    for (auto& t : workers) t.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "positions " << lines.size() << "  workers " << workerCount << "  time "
+              << static_cast<int>(seconds * 1000) << " ms  positions/s "
+              << (seconds > 0 ? lines.size() / seconds : 0) << std::endl;
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+using Bitboard = std::uint64_t;
+
+// Squares are numbered row * 8 + col, so square 0 is a8 and square 63 is h1,
+// matching the row/col layout used everywhere else on the board.
+namespace bb {
+
+constexpr int square(int row, int col) { return row * 8 + col; }
+constexpr int rowOf(int sq) { return sq >> 3; }
+constexpr int colOf(int sq) { return sq & 7; }
+constexpr Bitboard bit(int sq) { return Bitboard(1) << sq; }
+
+inline int popcount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// Ray directions: 0-3 are orthogonal (rook), 4-7 diagonal (bishop).
+enum Direction { NORTH, SOUTH, EAST, WEST, NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST };
+constexpr int DIR_ROW[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+constexpr int DIR_COL[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+// Rays that walk towards higher square numbers find their first blocker with
+// lsb, the others with msb.
+constexpr bool isPositive(int dir) {
+    return DIR_ROW[dir] > 0 || (DIR_ROW[dir] == 0 && DIR_COL[dir] > 0);
+}
+
+struct AttackTables {
+    Bitboard rays[8][64];
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];
+};
+
+constexpr bool onBoard(int row, int col) {
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+constexpr AttackTables makeAttackTables() {
+    AttackTables t{};
+    const int knightRow[8] = {-2, -2, -1, -1, 1, 1, 2, 2};
+    const int knightCol[8] = {-1, 1, -2, 2, -2, 2, -1, 1};
+
+    for (int sq = 0; sq < 64; ++sq) {
+        int r = rowOf(sq);
+        int c = colOf(sq);
+
+        for (int d = 0; d < 8; ++d) {
+            Bitboard ray = 0;
+            for (int rr = r + DIR_ROW[d], cc = c + DIR_COL[d]; onBoard(rr, cc); rr += DIR_ROW[d], cc += DIR_COL[d]) {
+                ray |= bit(square(rr, cc));
+            }
+            t.rays[d][sq] = ray;
+
+            if (onBoard(r + DIR_ROW[d], c + DIR_COL[d])) {
+                t.king[sq] |= bit(square(r + DIR_ROW[d], c + DIR_COL[d]));
+            }
+            if (onBoard(r + knightRow[d], c + knightCol[d])) {
+                t.knight[sq] |= bit(square(r + knightRow[d], c + knightCol[d]));
+            }
+        }
+
+        // White pawns move towards row 0, black pawns towards row 7.
+        for (int dc = -1; dc <= 1; dc += 2) {
+            if (onBoard(r - 1, c + dc)) t.pawn[0][sq] |= bit(square(r - 1, c + dc));
+            if (onBoard(r + 1, c + dc)) t.pawn[1][sq] |= bit(square(r + 1, c + dc));
+        }
+    }
+    return t;
+}
+
+inline constexpr AttackTables ATTACKS = makeAttackTables();
+
+inline Bitboard rayAttacks(int dir, int sq, Bitboard occupied) {
+    Bitboard ray = ATTACKS.rays[dir][sq];
+    Bitboard blockers = ray & occupied;
+    if (blockers) {
+        int first = isPositive(dir) ? lsb(blockers) : msb(blockers);
+        ray ^= ATTACKS.rays[dir][first];
+    }
+    return ray;
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    return rayAttacks(NORTH, sq, occupied) | rayAttacks(SOUTH, sq, occupied) |
+           rayAttacks(EAST, sq, occupied) | rayAttacks(WEST, sq, occupied);
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    return rayAttacks(NORTH_EAST, sq, occupied) | rayAttacks(NORTH_WEST, sq, occupied) |
+           rayAttacks(SOUTH_EAST, sq, occupied) | rayAttacks(SOUTH_WEST, sq, occupied);
+}
+
+}
+
+#endif
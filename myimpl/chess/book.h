@@ -0,0 +1,37 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "chess.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only Polyglot opening book. The file is memory-mapped and searched
+// in place, so opening it costs the same whatever its size; only the pages
+// a lookup touches are ever read. Entries are 16 bytes, big-endian and
+// sorted by key: key 8 | move 2 | weight 2 | learn 4.
+class OpeningBook {
+public:
+    OpeningBook() = default;
+    ~OpeningBook();
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // Returns false, leaving the book closed, if the file cannot be mapped.
+    bool open(const std::string& bookPath);
+    void close();
+    bool isOpen() const { return m_entries != nullptr; }
+    std::size_t size() const { return m_count; }
+
+    std::uint64_t key(const chessboard& board, bool whiteToMove) const;
+    // Highest-weight book move that is legal on the board; false when the
+    // position is not in the book.
+    bool probe(const chessboard& board, bool whiteToMove, Move& move) const;
+
+private:
+    const unsigned char* m_entries = nullptr;
+    std::size_t m_count = 0;
+    std::size_t m_mappedBytes = 0;
+};
+
+#endif
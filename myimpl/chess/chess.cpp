@@ -1,11 +1,23 @@
 #include <iostream>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <cctype>
-#include <functional>
+#include <sstream>
+#include <thread>
 #include <vector>
 #include "chess.h"
 
+// Stats hooks: with CHESS_SEARCH_STATS off they expand to nothing, so the
+// search pays neither the branch nor the clock reads.
+#ifdef CHESS_SEARCH_STATS
+#define SEARCH_STAT(expr) do { if (m_stats) m_stats->expr; } while (0)
+#define SEARCH_TIMER(field) StatsTimer statsTimer_##field(m_stats ? &m_stats->field : nullptr)
+#else
+#define SEARCH_STAT(expr) do {} while (0)
+#define SEARCH_TIMER(field) do {} while (0)
+#endif
+
 namespace {
 int pieceValue(char symbol) {
     switch (std::tolower(symbol)) {
@@ -18,72 +30,528 @@ int pieceValue(char symbol) {
         default: return 0;
     }
 }
+
+constexpr int DELTA_MARGIN = 200;
+
+// Null move: depth reduction on top of the skipped ply, deeper above
+// NULL_MOVE_DEEP_DEPTH, and the minimum depth worth trying it at.
+constexpr int NULL_MOVE_REDUCTION = 2;
+constexpr int NULL_MOVE_DEEP_REDUCTION = 3;
+constexpr int NULL_MOVE_DEEP_DEPTH = 6;
+constexpr int NULL_MOVE_MIN_DEPTH = 3;
+// Late move reductions start with the LMR_MIN_MOVES-th move searched.
+constexpr int LMR_MIN_DEPTH = 3;
+constexpr int LMR_MIN_MOVES = 3;
+// Lazy SMP helpers add their nodes to the shared count this many at a
+// time; a power of two.
+constexpr std::uint64_t NODE_REPORT_INTERVAL = 1024;
+
+// Piece-square tables from white's side, laid out like the board (a8 first).
+// Black uses the vertically mirrored square. The king and pawns get
+// separate endgame tables; the other pieces use the same one in both phases.
+constexpr int PAWN_MG[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0};
+constexpr int PAWN_EG[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0};
+constexpr int KNIGHT_PST[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50};
+constexpr int BISHOP_PST[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20};
+constexpr int ROOK_PST[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0};
+constexpr int QUEEN_PST[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20};
+constexpr int KING_MG[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20};
+constexpr int KING_EG[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50};
+
+constexpr const int* MG_TABLES[6] = {PAWN_MG, KNIGHT_PST, BISHOP_PST, ROOK_PST, QUEEN_PST, KING_MG};
+constexpr const int* EG_TABLES[6] = {PAWN_EG, KNIGHT_PST, BISHOP_PST, ROOK_PST, QUEEN_PST, KING_EG};
+constexpr int MG_VALUE[6] = {100, 320, 330, 500, 900, 0};
+constexpr int EG_VALUE[6] = {120, 300, 320, 520, 940, 0};
+
+// Game phase runs from PHASE_TOTAL with all minor and major pieces on the
+// board down to 0 with none.
+constexpr int PHASE_WEIGHT[6] = {0, 1, 1, 2, 4, 0};
+constexpr int PHASE_TOTAL = 24;
+
+// Material plus square bonus per piece code, signed from white's view, so
+// the board only adds or subtracts one entry when a piece appears or leaves.
+struct EvalTables {
+    int mg[12][64];
+    int eg[12][64];
+};
+
+constexpr EvalTables makeEvalTables() {
+    EvalTables t{};
+    for (int code = 0; code < 12; ++code) {
+        const int type = code % 6;
+        const bool white = code < 6;
+        for (int sq = 0; sq < 64; ++sq) {
+            const int own = white ? sq : sq ^ 56;
+            t.mg[code][sq] = (white ? 1 : -1) * (MG_VALUE[type] + MG_TABLES[type][own]);
+            t.eg[code][sq] = (white ? 1 : -1) * (EG_VALUE[type] + EG_TABLES[type][own]);
+        }
+    }
+    return t;
+}
+
+constexpr EvalTables EVAL = makeEvalTables();
+
+// Move ordering bands: hash move, then captures/promotions by MVV-LVA,
+// then the two killers, then quiet moves by history score, and last the
+// captures static exchange says lose material, scored by that loss.
+constexpr int HASH_MOVE_SCORE = 10000000;
+constexpr int CAPTURE_SCORE = 1000000;
+constexpr int KILLER_SCORE = 900000;
+constexpr int HISTORY_LIMIT = 500000;
+
+int mvvLva(char victim, char attacker) {
+    return 10 * pieceValue(victim) - pieceValue(attacker) / 100;
+}
+
+// pieceValue by PieceType, for the exchange loop.
+constexpr int SEE_VALUE[6] = {100, 320, 330, 500, 900, 20000};
+
+// Selection step of a lazy sort: bring the best remaining move to index i.
+void pickNext(MoveList& moves, int* scores, int i) {
+    int best = i;
+    for (int j = i + 1; j < moves.size(); ++j) {
+        if (scores[j] > scores[best]) best = j;
+    }
+    std::swap(moves[i], moves[best]);
+    std::swap(scores[i], scores[best]);
+}
+
+struct ZobristKeys {
+    std::uint64_t pieceSquare[12][64];
+    std::uint64_t blackToMove;
+    std::uint64_t castling[16];
+    std::uint64_t enPassantFile[8];
+};
+
+constexpr std::uint64_t splitMix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    std::uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int p = 0; p < 12; ++p)
+        for (int sq = 0; sq < 64; ++sq)
+            keys.pieceSquare[p][sq] = splitMix64(state);
+    keys.blackToMove = splitMix64(state);
+    // No rights hashes to zero so a bare placement keeps its old key.
+    for (int rights = 1; rights < 16; ++rights) keys.castling[rights] = splitMix64(state);
+    for (int file = 0; file < 8; ++file) keys.enPassantFile[file] = splitMix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+// Rights that survive a move touching each square: moving the king or a
+// rook from its home square, or capturing on one, clears them.
+constexpr std::uint8_t castlingMaskFor(int sq) {
+    switch (sq) {
+        case 0: return chessboard::ALL_CASTLING & ~chessboard::BLACK_OOO;
+        case 4: return chessboard::WHITE_OO | chessboard::WHITE_OOO;
+        case 7: return chessboard::ALL_CASTLING & ~chessboard::BLACK_OO;
+        case 56: return chessboard::ALL_CASTLING & ~chessboard::WHITE_OOO;
+        case 60: return chessboard::BLACK_OO | chessboard::BLACK_OOO;
+        case 63: return chessboard::ALL_CASTLING & ~chessboard::WHITE_OO;
+        default: return chessboard::ALL_CASTLING;
+    }
+}
+
+// Piece type a pawn promotes to; queen unless the move names another.
+constexpr int promotedType(Move m) {
+    switch (m.promotion()) {
+        case 'r': return ROOK;
+        case 'n': return KNIGHT;
+        case 'b': return BISHOP;
+        default: return QUEEN;
+    }
+}
+
+// King and rook squares of each castling move, the squares between them
+// that must be empty and the ones the king stands on or crosses, which
+// must not be attacked.
+struct CastlingMove {
+    int right, king, kingTo, rook, rookTo;
+    Bitboard empty, safe;
+};
+
+constexpr CastlingMove CASTLING_MOVES[4] = {
+    {chessboard::WHITE_OO, 60, 62, 63, 61, bb::bit(61) | bb::bit(62), bb::bit(60) | bb::bit(61) | bb::bit(62)},
+    {chessboard::WHITE_OOO, 60, 58, 56, 59, bb::bit(57) | bb::bit(58) | bb::bit(59), bb::bit(60) | bb::bit(59) | bb::bit(58)},
+    {chessboard::BLACK_OO, 4, 6, 7, 5, bb::bit(5) | bb::bit(6), bb::bit(4) | bb::bit(5) | bb::bit(6)},
+    {chessboard::BLACK_OOO, 4, 2, 0, 3, bb::bit(1) | bb::bit(2) | bb::bit(3), bb::bit(4) | bb::bit(3) | bb::bit(2)},
+};
+
+// Fifty moves by each side without a capture or pawn move.
+constexpr int FIFTY_MOVE_PLIES = 100;
+
+// Mate scores are stored relative to the node so they stay valid when the
+// same position is reached at a different ply.
+constexpr int MATE_BOUND = chessboard::MATE_SCORE - 1000;
+
+int scoreToTT(int score, int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+int elapsedMs(std::chrono::steady_clock::time_point start) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+#ifdef CHESS_SEARCH_STATS
+// Adds the lifetime of the scope to a SearchStats time field.
+class StatsTimer {
+public:
+    explicit StatsTimer(std::uint64_t* target)
+        : m_target(target), m_start(target ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+    ~StatsTimer() {
+        if (m_target) {
+            *m_target += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count());
+        }
+    }
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+private:
+    std::uint64_t* m_target;
+    std::chrono::steady_clock::time_point m_start;
+};
+#endif
+}
+
+namespace {
+// Packed entry layout: score 24 | depth 8 | bound 2 | move 16 |
+// generation 14. Scores stay within INFINITE_SCORE, far inside 24 bits.
+constexpr int DEPTH_SHIFT = 24;
+constexpr int BOUND_SHIFT = 32;
+constexpr int MOVE_SHIFT = 34;
+constexpr int GENERATION_SHIFT = 50;
+
+std::uint64_t packEntry(int score, int depth, TranspositionTable::Bound bound, Move best, std::uint64_t generation) {
+    return (static_cast<std::uint32_t>(score) & 0xFFFFFF) |
+           static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << DEPTH_SHIFT |
+           static_cast<std::uint64_t>(bound) << BOUND_SHIFT |
+           static_cast<std::uint64_t>(best.raw()) << MOVE_SHIFT |
+           generation << GENERATION_SHIFT;
+}
+
+int entryDepth(std::uint64_t data) {
+    return static_cast<std::int8_t>((data >> DEPTH_SHIFT) & 0xFF);
+}
+
+TranspositionTable::Entry unpackEntry(std::uint64_t key, std::uint64_t data) {
+    TranspositionTable::Entry e;
+    e.key = key;
+    // Sign-extend the 24-bit score.
+    e.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data << 8)) >> 8;
+    e.depth = static_cast<std::int8_t>(entryDepth(data));
+    e.bound = static_cast<TranspositionTable::Bound>((data >> BOUND_SHIFT) & 0x3);
+    e.move = Move::fromRaw(static_cast<std::uint16_t>(data >> MOVE_SHIFT));
+    return e;
+}
+}
+
+std::string SearchStats::toJSON() const {
+    std::ostringstream out;
+    out << "{\"enabled\":" << (enabled() ? "true" : "false")
+        << ",\"nodes\":" << nodes << ",\"qnodes\":" << qnodes << ",\"mate_nodes\":" << mateNodes
+        << ",\"tt_probes\":" << ttProbes << ",\"tt_hits\":" << ttHits << ",\"tt_cutoffs\":" << ttCutoffs
+        << ",\"cutoff_index\":[";
+    for (int i = 0; i < CUTOFF_BUCKETS; ++i) out << (i ? "," : "") << cutoffIndex[i];
+    out << "],\"movegen_calls\":" << moveGenCalls << ",\"is_check_calls\":" << isCheckCalls
+        << ",\"time_ns\":{\"search\":" << searchNs << ",\"quiescence\":" << quiescenceNs
+        << ",\"movegen\":" << moveGenNs << ",\"mate\":" << mateNs << "},\"trace\":[";
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const Iteration& it = trace[i];
+        out << (i ? "," : "") << "{\"depth\":" << it.depth << ",\"score\":" << it.score
+            << ",\"nodes\":" << it.nodes << ",\"qnodes\":" << it.qnodes << ",\"time_ms\":" << it.timeMs
+            << ",\"best\":\"" << moveToString(it.bestMove) << "\"}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+std::string moveToString(const Move& m) {
+    std::string s;
+    s += static_cast<char>('a' + m.fromCol());
+    s += static_cast<char>('0' + 8 - m.fromRow());
+    s += static_cast<char>('a' + m.toCol());
+    s += static_cast<char>('0' + 8 - m.toRow());
+    if (m.promotion()) s += m.promotion();
+    return s;
+}
+
+TranspositionTable::TranspositionTable(std::size_t sizeMB) {
+    resize(sizeMB);
+}
+
+void TranspositionTable::resize(std::size_t sizeMB) {
+    std::size_t count = 1;
+    const std::size_t budget = std::max<std::size_t>(sizeMB, 1) * 1024 * 1024 / sizeof(Slot);
+    while (count * 2 <= budget) count *= 2;
+
+    m_slots = std::make_unique<Slot[]>(count);
+    m_count = count;
+    m_mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i < m_count; ++i) {
+        m_slots[i].check.store(0, std::memory_order_relaxed);
+        m_slots[i].data.store(0, std::memory_order_relaxed);
+    }
 }
 
-chessboard::chessboard() : Matrix<PiecePtr>(BOARD_SIZE) {
+void TranspositionTable::newGeneration() {
+    m_generation = (m_generation + 1) % GENERATIONS;
+    if (m_generation == 0) clear();
+}
+
+bool TranspositionTable::probe(std::uint64_t key, Entry& out) const {
+    const Slot& slot = m_slots[key & m_mask];
+    std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if (data == 0 || (check ^ data) != key || data >> GENERATION_SHIFT != m_generation) return false;
+    out = unpackEntry(key, data);
+    return true;
+}
+
+void TranspositionTable::store(std::uint64_t key, int depth, int score, Bound bound, Move best) {
+    Slot& slot = m_slots[key & m_mask];
+    std::uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+    if ((oldCheck ^ oldData) == key && oldData >> GENERATION_SHIFT == m_generation && entryDepth(oldData) > depth) return;
+
+    std::uint64_t data = packEntry(score, depth, bound, best, m_generation);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+chessboard::chessboard() {
     initChessboard();
 }
 
 chessboard::chessboard(const chessboard& other)
-    : Matrix<PiecePtr>(other.getSize()),
-      whiteKingPos(other.whiteKingPos),
-      blackKingPos(other.blackKingPos)
+    : m_tt(other.m_tt)
 {
-    for (int i = 0; i < m_size; ++i) {
-        for (int j = 0; j < m_size; ++j) {
-            const auto& p = other.getElement(i, j);
-            this->setElement(i, j, p ? p->clone() : nullptr);
-        }
-    }
+    copyPosition(other);
 }
 
 chessboard& chessboard::operator=(const chessboard& other) {
     if (this != &other) {
-        this->whiteKingPos = other.whiteKingPos;
-        this->blackKingPos = other.blackKingPos;
-        for (int i = 0; i < m_size; ++i) {
-            for (int j = 0; j < m_size; ++j) {
-                const auto& p = other.getElement(i, j);
-                this->setElement(i, j, p ? p->clone() : nullptr);
-            }
-        }
+        copyPosition(other);
+        this->m_tt = other.m_tt;
     }
     return *this;
 }
 
-chessboard::~chessboard() {}
+void chessboard::copyPosition(const chessboard& other) {
+    whiteKingPos = other.whiteKingPos;
+    blackKingPos = other.blackKingPos;
+    std::memcpy(m_squares, other.m_squares, sizeof(m_squares));
+    std::memcpy(m_pieces, other.m_pieces, sizeof(m_pieces));
+    std::memcpy(m_colors, other.m_colors, sizeof(m_colors));
+    m_occupied = other.m_occupied;
+    m_key = other.m_key;
+    m_mgScore = other.m_mgScore;
+    m_egScore = other.m_egScore;
+    m_phase = other.m_phase;
+    m_castling = other.m_castling;
+    m_epSquare = other.m_epSquare;
+    m_halfmoveClock = other.m_halfmoveClock;
+    m_fullmoveNumber = other.m_fullmoveNumber;
+}
 
-PiecePtr chessboard::createPieceBySymbol(char symbol, int row, int col) {
-    bool isWhite = std::isupper(symbol);
-    switch (std::tolower(symbol)) {
-        case 'p': return std::make_unique<pawn>(row, col, isWhite);
-        case 'r': return std::make_unique<rook>(row, col, isWhite);
-        case 'n': return std::make_unique<knight>(row, col, isWhite);
-        case 'b': return std::make_unique<bishop>(row, col, isWhite);
-        case 'q': return std::make_unique<queen>(row, col, isWhite);
-        case 'k': return std::make_unique<king>(row, col, isWhite);
-        default: return nullptr;
+void chessboard::toggleMasks(int code, int sq) {
+    Bitboard b = bb::bit(sq);
+    m_pieces[code] ^= b;
+    m_colors[piece::isWhite(code) ? 0 : 1] ^= b;
+    m_occupied ^= b;
+    m_key ^= ZOBRIST.pieceSquare[code][sq];
+}
+
+void chessboard::setCastling(int rights) {
+    m_key ^= ZOBRIST.castling[m_castling] ^ ZOBRIST.castling[rights];
+    m_castling = static_cast<std::uint8_t>(rights);
+}
+
+void chessboard::setEnPassant(int sq) {
+    if (m_epSquare >= 0) m_key ^= ZOBRIST.enPassantFile[bb::colOf(m_epSquare)];
+    if (sq >= 0) m_key ^= ZOBRIST.enPassantFile[bb::colOf(sq)];
+    m_epSquare = static_cast<std::int8_t>(sq);
+}
+
+std::uint64_t chessboard::positionKey(bool whiteToMove) const {
+    return whiteToMove ? m_key : m_key ^ ZOBRIST.blackToMove;
+}
+
+// Mirrors the key updates of doMove.
+std::uint64_t chessboard::positionKeyAfter(Move m) const {
+    const int from = m.from();
+    const int to = m.to();
+    const int code = m_squares[from];
+    const bool isWhite = piece::isWhite(code);
+    const int type = piece::type(code);
+    std::uint64_t key = m_key ^ ZOBRIST.pieceSquare[code][from];
+
+    if (type == PAWN && m.fromCol() != m.toCol() && m_squares[to] == NO_PIECE) {
+        const int captured = bb::square(m.fromRow(), m.toCol());
+        key ^= ZOBRIST.pieceSquare[m_squares[captured]][captured];
+    } else if (m_squares[to] != NO_PIECE) {
+        key ^= ZOBRIST.pieceSquare[m_squares[to]][to];
+    }
+
+    const bool promotes = type == PAWN && (m.toRow() == 0 || m.toRow() == 7);
+    key ^= ZOBRIST.pieceSquare[promotes ? piece::make(promotedType(m), isWhite) : code][to];
+
+    if (type == KING && std::abs(m.toCol() - m.fromCol()) == 2) {
+        const int rook = piece::make(ROOK, isWhite);
+        const bool kingside = m.toCol() > m.fromCol();
+        key ^= ZOBRIST.pieceSquare[rook][bb::square(m.toRow(), kingside ? 7 : 0)];
+        key ^= ZOBRIST.pieceSquare[rook][bb::square(m.toRow(), kingside ? 5 : 3)];
+    }
+
+    key ^= ZOBRIST.castling[m_castling] ^ ZOBRIST.castling[m_castling & castlingMaskFor(from) & castlingMaskFor(to)];
+    if (m_epSquare >= 0) key ^= ZOBRIST.enPassantFile[bb::colOf(m_epSquare)];
+    if (type == PAWN && std::abs(m.toRow() - m.fromRow()) == 2) {
+        const int passed = bb::square((m.fromRow() + m.toRow()) / 2, m.fromCol());
+        if (bb::ATTACKS.pawn[isWhite ? 0 : 1][passed] & m_pieces[piece::make(PAWN, !isWhite)]) key ^= ZOBRIST.enPassantFile[m.fromCol()];
     }
+    return isWhite ? key ^ ZOBRIST.blackToMove : key;
 }
 
-void chessboard::refreshKingPositions() {
-    position newWhite{-1, -1};
-    position newBlack{-1, -1};
-
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            const auto& p = getElement(r, c);
-            if (!p || std::tolower(p->getSymbol()) != 'k') continue;
-            if (p->isWhite()) {
-                if (newWhite.row == -1) newWhite = {r, c};
-            } else {
-                if (newBlack.row == -1) newBlack = {r, c};
-            }
-        }
+// Only positions since the last capture or pawn move can recur, and only
+// with the same side to move, so the scan steps back two plies at a time
+// starting four plies back: along the search path first, then into the
+// game history the caller passed in.
+bool chessboard::isRepetition(std::uint64_t key, int ply) const {
+    const std::vector<std::uint64_t>* game = m_control.gameHistory;
+    const int gameSize = game ? static_cast<int>(game->size()) : 0;
+    const int window = std::min(m_halfmoveClock, ply + gameSize);
+
+    for (int back = 4; back <= window; back += 2) {
+        const std::uint64_t earlier = back <= ply ? m_path->keys[ply - back] : (*game)[gameSize - (back - ply)];
+        if (earlier == key) return true;
+    }
+    return false;
+}
+
+void chessboard::setHashSize(std::size_t sizeMB) {
+    if (m_tt) m_tt->resize(sizeMB);
+    else m_tt = std::make_shared<TranspositionTable>(sizeMB);
+}
+
+void chessboard::clearHash() {
+    if (m_tt) m_tt->clear();
+}
+
+void chessboard::newHashGeneration() {
+    if (m_tt) m_tt->newGeneration();
+}
+
+void chessboard::putPiece(int code, int sq) {
+    m_squares[sq] = static_cast<std::uint8_t>(code);
+    toggleMasks(code, sq);
+    m_mgScore += EVAL.mg[code][sq];
+    m_egScore += EVAL.eg[code][sq];
+    m_phase += PHASE_WEIGHT[piece::type(code)];
+}
+
+int chessboard::removePiece(int sq) {
+    int code = m_squares[sq];
+    if (code != NO_PIECE) {
+        toggleMasks(code, sq);
+        m_squares[sq] = NO_PIECE;
+        m_mgScore -= EVAL.mg[code][sq];
+        m_egScore -= EVAL.eg[code][sq];
+        m_phase -= PHASE_WEIGHT[piece::type(code)];
     }
+    return code;
+}
 
-    whiteKingPos = newWhite;
-    blackKingPos = newBlack;
+void chessboard::refreshKingPositions() {
+    // lsb is the first king in row-major order, same as a top-left scan.
+    Bitboard white = m_pieces[WHITE_KING];
+    Bitboard black = m_pieces[BLACK_KING];
+
+    whiteKingPos = white ? position{bb::rowOf(bb::lsb(white)), bb::colOf(bb::lsb(white))} : position{-1, -1};
+    blackKingPos = black ? position{bb::rowOf(bb::lsb(black)), bb::colOf(bb::lsb(black))} : position{-1, -1};
 }
 
 bool chessboard::makeMove(int fromRow, int fromCol, int toRow, int toCol, char promotionPiece) {
@@ -92,343 +560,1276 @@ bool chessboard::makeMove(int fromRow, int fromCol, int toRow, int toCol, char p
 }
 
 bool chessboard::makeMoveUndo(int fromRow, int fromCol, int toRow, int toCol, char promotionPiece, MoveRecord& rec) {
-    if (isempty(fromRow, fromCol)) return false;
+    if (fromRow < 0 || fromRow >= BOARD_SIZE || fromCol < 0 || fromCol >= BOARD_SIZE) return false;
+    if (toRow < 0 || toRow >= BOARD_SIZE || toCol < 0 || toCol >= BOARD_SIZE) return false;
+
+    int from = bb::square(fromRow, fromCol);
+    int code = m_squares[from];
+    if (code == NO_PIECE) return false;
+
+    const bool white = piece::isWhite(code);
+    const int to = bb::square(toRow, toCol);
+
+    // Callers may pass any promotion letter, or none; a pawn reaching the
+    // last rank becomes a queen unless asked otherwise.
+    char promotion = 0;
+    if (piece::type(code) == PAWN && (toRow == 0 || toRow == BOARD_SIZE - 1)) {
+        promotion = std::tolower(promotionPiece);
+        if (promotion != 'r' && promotion != 'n' && promotion != 'b') promotion = 'q';
+    }
 
-    PiecePtr& movingPiece = getElement(fromRow, fromCol);
-    bool isWhite = movingPiece->isWhite();
-    
-    
-    if (!movingPiece->isvalidmove(toRow, toCol, *this)) return false;
+    // Moves from outside are matched against the legal list, which also
+    // covers castling and en passant and supplies the capture flag.
+    for (const Move m : generateLegalMoves(white)) {
+        if (m.from() == from && m.to() == to && m.promotion() == promotion) {
+            doMove(m, rec);
+            return true;
+        }
+    }
+    return false;
+}
+
+void chessboard::doMove(Move m, MoveRecord& rec) {
+    const int from = m.from();
+    const int to = m.to();
+    const int fromRow = m.fromRow(), fromCol = m.fromCol();
+    const int toRow = m.toRow(), toCol = m.toCol();
+    const int code = m_squares[from];
+    const bool isWhite = piece::isWhite(code);
+    const int type = piece::type(code);
 
-    
     rec.fromR = fromRow; rec.fromC = fromCol;
     rec.toR = toRow; rec.toC = toCol;
     rec.prevWhiteKing = whiteKingPos;
     rec.prevBlackKing = blackKingPos;
-    rec.originalType = movingPiece->getSymbol();
-    rec.moved = movingPiece->hasMoved();
-    rec.captured = std::move(getElement(toRow, toCol));
+
+    // A pawn moving diagonally onto an empty square takes en passant; the
+    // captured pawn stands beside it, on the row it came from.
+    rec.enPassant = type == PAWN && fromCol != toCol && m_squares[to] == NO_PIECE;
+    rec.moving = static_cast<std::uint8_t>(code);
+    rec.captured = static_cast<std::uint8_t>(removePiece(rec.enPassant ? bb::square(fromRow, toCol) : to));
     rec.promotion = false;
     rec.castling = false;
-
-    char symbol = std::tolower(rec.originalType);
+    rec.prevCastling = m_castling;
+    rec.prevEpSquare = m_epSquare;
+    rec.prevHalfmoveClock = m_halfmoveClock;
+    rec.prevFullmoveNumber = m_fullmoveNumber;
 
     
-    if (symbol == 'k' && std::abs(toCol - fromCol) == 2) {
+    if (type == KING && std::abs(toCol - fromCol) == 2) {
         rec.castling = true;
         rec.rookFromC = (toCol > fromCol) ? 7 : 0;
         rec.rookToC = (toCol > fromCol) ? 5 : 3;
     }
 
     
-    setElement(toRow, toCol, std::move(movingPiece));
-    setElement(fromRow, fromCol, nullptr);
-
-    PiecePtr& p = getElement(toRow, toCol);
-    p->setRow(toRow);
-    p->setCol(toCol);
-    p->setMoved(true);
+    removePiece(from);
+    putPiece(code, to);
 
-    if (symbol == 'k') {
+    if (type == KING) {
         if (isWhite) whiteKingPos = {toRow, toCol};
         else blackKingPos = {toRow, toCol};
     }
 
     
-    if (isCheck(isWhite)) {
-        undoMove(rec);
-        return false;
-    }
-
-    
     if (rec.castling) {
-        PiecePtr& rook = getElement(toRow, rec.rookFromC);
-        rec.rookMoved = rook->hasMoved();
-        setElement(toRow, rec.rookToC, std::move(rook));
-        setElement(toRow, rec.rookFromC, nullptr);
-        getElement(toRow, rec.rookToC)->setCol(rec.rookToC);
-        getElement(toRow, rec.rookToC)->setMoved(true);
+        removePiece(bb::square(toRow, rec.rookFromC));
+        putPiece(piece::make(ROOK, isWhite), bb::square(toRow, rec.rookToC));
     }
 
     
-    if (symbol == 'p' && (toRow == 0 || toRow == 7)) {
+    if (type == PAWN && (toRow == 0 || toRow == 7)) {
         rec.promotion = true;
-        char choice = std::tolower(promotionPiece);
-        if (choice == 'r') setElement(toRow, toCol, createPieceBySymbol(isWhite ? 'R' : 'r', toRow, toCol));
-        else if (choice == 'n') setElement(toRow, toCol, createPieceBySymbol(isWhite ? 'N' : 'n', toRow, toCol));
-        else if (choice == 'b') setElement(toRow, toCol, createPieceBySymbol(isWhite ? 'B' : 'b', toRow, toCol));
-        else setElement(toRow, toCol, createPieceBySymbol(isWhite ? 'Q' : 'q', toRow, toCol));
-        getElement(toRow, toCol)->setMoved(true);
+        removePiece(to);
+        putPiece(piece::make(promotedType(m), isWhite), to);
     }
 
-    return true;
+    setCastling(m_castling & castlingMaskFor(from) & castlingMaskFor(to));
+    // Only record an en passant square an enemy pawn could actually capture
+    // on, so the key of an otherwise identical position does not change.
+    int epSquare = -1;
+    if (type == PAWN && std::abs(toRow - fromRow) == 2) {
+        int passed = bb::square((fromRow + toRow) / 2, fromCol);
+        if (bb::ATTACKS.pawn[isWhite ? 0 : 1][passed] & m_pieces[piece::make(PAWN, !isWhite)]) epSquare = passed;
+    }
+    setEnPassant(epSquare);
+    m_halfmoveClock = (type == PAWN || rec.captured != NO_PIECE) ? 0 : m_halfmoveClock + 1;
+    if (!isWhite) ++m_fullmoveNumber;
 }
 
 void chessboard::undoMove(MoveRecord& rec) {
     whiteKingPos = rec.prevWhiteKing;
     blackKingPos = rec.prevBlackKing;
 
+    const int from = bb::square(rec.fromR, rec.fromC);
+    const int to = bb::square(rec.toR, rec.toC);
+
     if (rec.castling) {
-        PiecePtr& rook = getElement(rec.toR, rec.rookToC);
-        setElement(rec.toR, rec.rookFromC, std::move(rook));
-        setElement(rec.toR, rec.rookToC, nullptr);
-        getElement(rec.toR, rec.rookFromC)->setCol(rec.rookFromC);
-        getElement(rec.toR, rec.rookFromC)->setMoved(rec.rookMoved);
+        removePiece(bb::square(rec.toR, rec.rookToC));
+        putPiece(piece::make(ROOK, piece::isWhite(rec.moving)), bb::square(rec.toR, rec.rookFromC));
     }
 
-    if (rec.promotion) {
-        bool w = std::isupper(rec.originalType);
-        setElement(rec.fromR, rec.fromC, createPieceBySymbol(w ? 'P' : 'p', rec.fromR, rec.fromC));
-        getElement(rec.fromR, rec.fromC)->setMoved(rec.moved);
-    } else {
-        setElement(rec.fromR, rec.fromC, std::move(getElement(rec.toR, rec.toC)));
-        auto& p = getElement(rec.fromR, rec.fromC);
-        p->setRow(rec.fromR);
-        p->setCol(rec.fromC);
-        p->setMoved(rec.moved);
-    }
+    removePiece(to);
+    putPiece(rec.moving, from);
+    if (rec.captured != NO_PIECE) putPiece(rec.captured, rec.enPassant ? bb::square(rec.fromR, rec.toC) : to);
 
-    setElement(rec.toR, rec.toC, std::move(rec.captured));
+    setCastling(rec.prevCastling);
+    setEnPassant(rec.prevEpSquare);
+    m_halfmoveClock = rec.prevHalfmoveClock;
+    m_fullmoveNumber = rec.prevFullmoveNumber;
 }
 
 void chessboard::placePiece(char symbol, int row, int col) {
+    int sq = bb::square(row, col);
     if (symbol == '.') {
-        setElement(row, col, nullptr);
+        removePiece(sq);
         this->refreshKingPositions();
         return;
     }
 
-    PiecePtr created = createPieceBySymbol(symbol, row, col);
-    if (!created) return;
-    setElement(row, col, std::move(created));
+    int code = piece::fromSymbol(symbol);
+    if (code == NO_PIECE) return;
+    removePiece(sq);
+    putPiece(code, sq);
 
     this->refreshKingPositions();
 }
 
-int chessboard::findMate(int maxDepth, bool whiteToMove, std::vector<Move>& sequence) {
-    if (maxDepth <= 0) return -1;
+// Proof and disproof numbers for the df-pn solver, keyed on position and
+// remaining depth, in buckets of four. A new position evicts the entry of
+// its bucket that took the fewest expansions to compute, so the cheap
+// leaves a sibling seesaw churns through do not push out the expensive
+// subtrees above them.
+class MateTable {
+public:
+    static constexpr std::uint32_t INFINITE = 100000000;
+
+    // As many buckets as maxEntries needs, within sizeMB.
+    MateTable(std::size_t sizeMB, std::uint64_t maxEntries) {
+        const std::size_t budget = std::max<std::size_t>(1, sizeMB * 1024 * 1024 / sizeof(Bucket));
+        const std::uint64_t wanted = maxEntries / BUCKET_SIZE + 1;
+        std::size_t count = 1;
+        while (count * 2 <= budget && count < wanted) count *= 2;
+        m_buckets.resize(count);
+        m_mask = count - 1;
+    }
 
-    const bool attackerIsWhite = whiteToMove;
-    constexpr int INF = 1000000;
+    // A position not in the table reads as pn = dn = 1 with no work done.
+    void probe(std::uint64_t key, std::uint32_t& pn, std::uint32_t& dn, std::uint64_t& work) const {
+        for (const Entry& e : m_buckets[key & m_mask].entries) {
+            if (e.key == key) {
+                pn = e.pn;
+                dn = e.dn;
+                work = e.work;
+                return;
+            }
+        }
+        pn = dn = 1;
+        work = 0;
+    }
 
-    std::function<int(int, bool, std::vector<Move>&)> dfs = [&](int depth, bool sideToMove, std::vector<Move>& line) -> int {
-        if (isCheckmate(sideToMove)) {
-            line.clear();
-            return (sideToMove != attackerIsWhite) ? 0 : -1;
+    void store(std::uint64_t key, std::uint32_t pn, std::uint32_t dn, std::uint64_t work) {
+        Entry* entries = m_buckets[key & m_mask].entries;
+        Entry* slot = &entries[0];
+        for (int i = 0; i < BUCKET_SIZE; ++i) {
+            if (entries[i].key == key) {
+                slot = &entries[i];
+                break;
+            }
+            if (entries[i].work < slot->work) slot = &entries[i];
         }
+        *slot = Entry{key, work, pn, dn};
+    }
 
-        if (depth == 0) return -1;
+private:
+    static constexpr int BUCKET_SIZE = 4;
 
-        std::vector<Move> moves = generateLegalMoves(sideToMove, true);
-        if (moves.empty()) return -1;
+    struct Entry {
+        std::uint64_t key = 0;
+        std::uint64_t work = 0;
+        std::uint32_t pn = 1;
+        std::uint32_t dn = 1;
+    };
+    struct Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
 
-        if (sideToMove == attackerIsWhite) {
-            int best = INF;
-            std::vector<Move> bestLine;
+    std::vector<Bucket> m_buckets;
+    std::size_t m_mask;
+};
 
-            for (const auto& m : moves) {
-                MoveRecord rec;
-                if (!makeMoveUndo(m.fromRow, m.fromCol, m.toRow, m.toCol, m.promotion, rec)) continue;
+namespace {
+// Upper bound on the solver's table; smaller node budgets get less.
+constexpr std::size_t MATE_TABLE_MB = 32;
 
-                std::vector<Move> childLine;
-                int res = dfs(depth - 1, !sideToMove, childLine);
-                undoMove(rec);
+std::uint32_t addCapped(std::uint32_t a, std::uint32_t b) {
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(std::uint64_t(a) + b, MateTable::INFINITE));
+}
 
-                if (res == -1) continue;
-                int mateDepth = res + 1;
-                if (mateDepth < best) {
-                    best = mateDepth;
-                    bestLine.clear();
-                    bestLine.push_back(m);
-                    bestLine.insert(bestLine.end(), childLine.begin(), childLine.end());
-                }
-            }
+std::uint64_t mateKey(std::uint64_t positionKey, int depth) {
+    return positionKey ^ (static_cast<std::uint64_t>(depth + 1) * 0x9E3779B97F4A7C15ULL);
+}
+}
+
+// One df-pn expansion: keeps working below this node until its proof or
+// disproof number reaches the given threshold, then stores both. The
+// attacker's nodes are OR nodes (one proven child proves them), the
+// defender's are AND nodes. A node is proven when the defender is mated
+// within depth plies.
+MoveList chessboard::mateMoves(bool whiteTurn, bool attackerIsWhite, MateSearchMode mode) const {
+    if (mode == MateSearchMode::CHECKS_ONLY && whiteTurn == attackerIsWhite) return generateCheckingMoves(whiteTurn);
+    return generateLegalMoves(whiteTurn);
+}
+
+// Only a checking move can mate, so the last attacker ply needs neither
+// the full move list nor a table entry per child.
+bool chessboard::mateInOne(bool whiteTurn) {
+    for (const auto& m : generateCheckingMoves(whiteTurn)) {
+        MoveRecord rec;
+        doMove(m, rec);
+        const bool mated = !hasLegalMove(!whiteTurn);
+        undoMove(rec);
+        if (mated) return true;
+    }
+    return false;
+}
 
-            if (best == INF) return -1;
-            line = bestLine;
-            return best;
+void chessboard::mateSearch(int depth, bool whiteTurn, bool attackerIsWhite, MateSearchMode mode, std::uint32_t thresholdPn, std::uint32_t thresholdDn, MateTable& table) {
+    constexpr std::uint32_t INF = MateTable::INFINITE;
+    if (limitReached()) return;
+    SEARCH_STAT(mateNodes++);
+
+    const std::uint64_t key = mateKey(positionKey(whiteTurn), depth);
+    const bool orNode = whiteTurn == attackerIsWhite;
+    // Expansions below this node, counting earlier visits, decide which
+    // entries the table keeps.
+    const std::uint64_t startNodes = m_control.nodes;
+    std::uint32_t pn, dn;
+    std::uint64_t work;
+    table.probe(key, pn, dn, work);
+
+    if (depth <= 1) {
+        const bool mated = depth == 0 ? !orNode && isCheck(whiteTurn) && !hasLegalMove(whiteTurn)
+                                      : orNode && mateInOne(whiteTurn);
+        table.store(key, mated ? 0 : INF, mated ? INF : 0, work + 1);
+        return;
+    }
+
+    MoveList moves = mateMoves(whiteTurn, attackerIsWhite, mode);
+    if (moves.empty()) {
+        bool mated = !orNode && isCheck(whiteTurn);
+        table.store(key, mated ? 0 : INF, mated ? INF : 0, work + 1);
+        return;
+    }
+
+    std::uint64_t childKeys[MoveList::CAPACITY];
+    for (int i = 0; i < moves.size(); ++i) childKeys[i] = mateKey(positionKeyAfter(moves[i]), depth - 1);
+
+    while (true) {
+        // OR node: pn is the smallest child pn, dn the sum of child dns.
+        // AND node: the other way round. "Own" is the number being minimised.
+        std::uint32_t own = INF, sum = 0, second = INF, bestOther = 0;
+        int best = 0;
+        for (int i = 0; i < moves.size(); ++i) {
+            std::uint32_t childPn, childDn;
+            std::uint64_t childWork;
+            table.probe(childKeys[i], childPn, childDn, childWork);
+            std::uint32_t childOwn = orNode ? childPn : childDn;
+            std::uint32_t childOther = orNode ? childDn : childPn;
+
+            sum = addCapped(sum, childOther);
+            if (childOwn < own) {
+                second = own;
+                own = childOwn;
+                best = i;
+                bestOther = childOther;
+            } else if (childOwn < second) {
+                second = childOwn;
+            }
         }
 
-        int worst = -1;
-        std::vector<Move> worstLine;
+        pn = orNode ? own : sum;
+        dn = orNode ? sum : own;
+        table.store(key, pn, dn, work + (m_control.nodes - startNodes) + 1);
+        if (pn >= thresholdPn || dn >= thresholdDn || m_control.stopped) return;
+
+        // The best child may run a quarter past the runner-up before
+        // control comes back here (1+epsilon df-pn); switching at exactly
+        // the runner-up makes two close siblings take turns every
+        // expansion, each time re-entering from this node.
+        const std::uint32_t ownThreshold = orNode ? thresholdPn : thresholdDn;
+        const std::uint32_t otherThreshold = orNode ? thresholdDn : thresholdPn;
+        std::uint32_t childOwnThreshold = std::min(ownThreshold, addCapped(second, second / 4 + 1));
+        std::uint32_t childOtherThreshold = otherThreshold >= INF ? INF : addCapped(otherThreshold - sum, bestOther);
+
+        MoveRecord rec;
+        doMove(moves[best], rec);
+        if (orNode) mateSearch(depth - 1, !whiteTurn, attackerIsWhite, mode, childOwnThreshold, childOtherThreshold, table);
+        else mateSearch(depth - 1, !whiteTurn, attackerIsWhite, mode, childOtherThreshold, childOwnThreshold, table);
+        undoMove(rec);
+    }
+}
 
-        for (const auto& m : moves) {
-            MoveRecord rec;
-            if (!makeMoveUndo(m.fromRow, m.fromCol, m.toRow, m.toCol, m.promotion, rec)) continue;
+// Fewest plies, up to maxDepth, in which the attacker mates from here, -1,
+// or MATE_UNKNOWN once the limits stop the search.
+// Depths step by two so the last ply is always the attacker's.
+int chessboard::shortestMate(int maxDepth, bool whiteTurn, bool attackerIsWhite, MateSearchMode mode, MateTable& table) {
+    for (int depth = (whiteTurn == attackerIsWhite) ? 1 : 0; depth <= maxDepth; depth += 2) {
+        mateSearch(depth, whiteTurn, attackerIsWhite, mode, MateTable::INFINITE, MateTable::INFINITE, table);
+
+        std::uint32_t pn, dn;
+        std::uint64_t work;
+        table.probe(mateKey(positionKey(whiteTurn), depth), pn, dn, work);
+        if (pn == 0) return depth;
+        if (m_control.stopped) return MATE_UNKNOWN;
+    }
+    return -1;
+}
+
+int chessboard::findMate(int maxDepth, bool whiteToMove, std::vector<Move>& sequence, MateSearchMode mode, const SearchLimits& limits) {
+    sequence.clear();
+    if (maxDepth <= 0) return -1;
+    SEARCH_TIMER(mateNs);
+
+    m_control = SearchControl{};
+    m_control.nodeLimit = (limits.nodes || limits.timeMs) ? limits.nodes : DEFAULT_MATE_NODES;
+    m_control.timed = limits.timeMs > 0;
+    m_control.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.timeMs);
+    m_control.sharedStop = limits.stop;
+
+    MateTable table(MATE_TABLE_MB, m_control.nodeLimit ? m_control.nodeLimit : DEFAULT_MATE_NODES);
+    const int mateIn = shortestMate(maxDepth, whiteToMove, whiteToMove, mode, table);
+    if (mateIn < 0) {
+        m_control = SearchControl{};
+        return mateIn;
+    }
 
-            std::vector<Move> childLine;
-            int res = dfs(depth - 1, !sideToMove, childLine);
+    // Walk the proof once: the attacker takes the quickest mate, the
+    // defender the move that delays it longest. Nearly every child lookup
+    // hits the table filled by the search above; the walk gets a node
+    // budget of its own but no deadline, and stops early only on that.
+    m_control.nodes = 0;
+    m_control.stopped = false;
+    m_control.timed = false;
+    if (!m_control.nodeLimit) m_control.nodeLimit = DEFAULT_MATE_NODES;
+
+    std::vector<MoveRecord> played;
+    bool side = whiteToMove;
+    for (int remaining = mateIn; remaining > 0 && !m_control.stopped; side = !side) {
+        const bool attacker = side == whiteToMove;
+        int bestDepth = -1;
+        Move bestMove{};
+
+        for (const auto& m : mateMoves(side, whiteToMove, mode)) {
+            MoveRecord rec;
+            doMove(m, rec);
+            int d = shortestMate(remaining - 1, !side, whiteToMove, mode, table);
             undoMove(rec);
 
-            if (res == -1) return -1;
+            if (d < 0) continue;
+            if (bestDepth < 0 || (attacker ? d < bestDepth : d > bestDepth)) {
+                bestDepth = d;
+                bestMove = m;
+            }
+        }
+        if (bestDepth < 0) break;
+
+        played.emplace_back();
+        doMove(bestMove, played.back());
+        sequence.push_back(bestMove);
+        remaining = bestDepth;
+    }
+
+    for (auto it = played.rbegin(); it != played.rend(); ++it) undoMove(*it);
+    m_control = SearchControl{};
+    return mateIn;
+}
+
+chessboard::LegalMasks chessboard::legalMasks(bool whiteTurn) const {
+    LegalMasks masks;
+    const Bitboard kings = m_pieces[piece::make(KING, whiteTurn)];
+    if (!kings) return masks;
+    masks.king = bb::lsb(kings);
+
+    const Bitboard own = occupancy(whiteTurn);
+    const Bitboard checkers = attackersTo(masks.king, m_occupied) & occupancy(!whiteTurn);
+    const int checks = bb::popcount(checkers);
+    if (checks > 1) masks.checkMask = 0;
+    else if (checks == 1) masks.checkMask = checkers;
+
+    const Bitboard queens = m_pieces[piece::make(QUEEN, !whiteTurn)];
+    for (int dir = 0; dir < 8; ++dir) {
+        const Bitboard ray = bb::rayAttacks(dir, masks.king, m_occupied);
+        // The checker ends this ray, so nothing on it can be pinned; a
+        // single check along it can be blocked anywhere on the way.
+        if (ray & checkers) {
+            if (checks == 1) masks.checkMask = ray;
+            continue;
+        }
+
+        const Bitboard blocker = ray & own;
+        if (!blocker) continue;
+        const int diagonal = dir >= bb::NORTH_EAST;
+        const Bitboard sliders = m_pieces[piece::make(diagonal ? BISHOP : ROOK, !whiteTurn)] | queens;
+        const Bitboard behind = bb::rayAttacks(dir, bb::lsb(blocker), m_occupied);
+        if (behind & sliders) {
+            masks.pinned |= blocker;
+            masks.pinLines[dir] = ray | behind;
+        }
+    }
+    return masks;
+}
 
-            int mateDepth = res + 1;
-            if (mateDepth > worst) {
-                worst = mateDepth;
-                worstLine.clear();
-                worstLine.push_back(m);
-                worstLine.insert(worstLine.end(), childLine.begin(), childLine.end());
+// The king steps off the board for the attack test so a slider checking
+// it along a line still covers the square behind it.
+Bitboard chessboard::legalTargets(const LegalMasks& masks, int code, int from, Bitboard targets) const {
+    if (piece::type(code) == KING) {
+        Bitboard legal = 0;
+        const Bitboard occupied = m_occupied & ~bb::bit(from);
+        while (targets) {
+            const int to = bb::popLsb(targets);
+            if (!isSquareAttacked(to, !piece::isWhite(code), occupied, ~bb::bit(to))) legal |= bb::bit(to);
+        }
+        return legal;
+    }
+
+    targets &= masks.checkMask;
+    if (masks.pinned & bb::bit(from)) {
+        for (Bitboard line : masks.pinLines) {
+            if (line & bb::bit(from)) targets &= line;
+        }
+    }
+    return targets;
+}
+
+void chessboard::generateMoves(bool whiteTurn, MoveList& moves, bool capturesOnly) const {
+    SEARCH_STAT(moveGenCalls++);
+    SEARCH_TIMER(moveGenNs);
+    const LegalMasks masks = legalMasks(whiteTurn);
+    const int us = whiteTurn ? 0 : 1;
+    const Bitboard own = m_colors[us];
+    const Bitboard enemy = m_colors[1 - us];
+    // Quiet moves are dropped in captures-only mode, except pawn pushes
+    // that promote.
+    const Bitboard promotionRank = whiteTurn ? 0xFFULL : 0xFFULL << 56;
+
+    for (int type = PAWN; type <= KING; ++type) {
+        const int code = piece::make(type, whiteTurn);
+        Bitboard pieces = m_pieces[code];
+        while (pieces) {
+            int from = bb::popLsb(pieces);
+            Bitboard targets = piece::moveTargets(code, from, own, enemy);
+            if (capturesOnly) targets &= (type == PAWN) ? (enemy | promotionRank) : enemy;
+            targets = legalTargets(masks, code, from, targets);
+
+            while (targets) {
+                int to = bb::popLsb(targets);
+                const bool capture = (enemy & bb::bit(to)) != 0;
+                if (type == PAWN && (promotionRank & bb::bit(to))) {
+                    for (char promo : {'q', 'r', 'b', 'n'}) moves.push(Move(from, to, promo, capture));
+                } else {
+                    moves.push(Move(from, to, 0, capture));
+                }
             }
         }
+    }
 
-        if (worst == -1) return -1;
-        line = worstLine;
-        return worst;
-    };
+    generateEnPassant(whiteTurn, moves);
+    if (!capturesOnly && masks.checkMask == ~Bitboard(0)) generateCastling(whiteTurn, moves);
+}
+
+// The only move that removes a piece from a square other than its target,
+// so it gets the full test: take both pawns off, put ours on the passed
+// square and look at the king. That also catches the pin along the row
+// through both pawns, which no pin mask sees.
+void chessboard::generateEnPassant(bool whiteTurn, MoveList& moves) const {
+    if (m_epSquare < 0) return;
+    const int captured = m_epSquare + (whiteTurn ? 8 : -8);
+    const Bitboard kings = m_pieces[piece::make(KING, whiteTurn)];
+
+    Bitboard pawns = bb::ATTACKS.pawn[whiteTurn ? 1 : 0][m_epSquare] & m_pieces[piece::make(PAWN, whiteTurn)];
+    while (pawns) {
+        const int from = bb::popLsb(pawns);
+        const Bitboard occupied = (m_occupied & ~bb::bit(from) & ~bb::bit(captured)) | bb::bit(m_epSquare);
+        if (kings && isSquareAttacked(bb::lsb(kings), !whiteTurn, occupied, ~bb::bit(captured))) continue;
+        moves.push(Move(from, m_epSquare, 0, true));
+    }
+}
+
+// Callers make sure the king is not in check; the king square is tested
+// again here only as part of the path.
+void chessboard::generateCastling(bool whiteTurn, MoveList& moves) const {
+    const int rights = m_castling & (whiteTurn ? (WHITE_OO | WHITE_OOO) : (BLACK_OO | BLACK_OOO));
+    if (!rights) return;
+
+    for (const auto& c : CASTLING_MOVES) {
+        if (!(rights & c.right) || (m_occupied & c.empty)) continue;
+        // Rights are kept in step with the pieces, but an edited board may not be.
+        if (m_squares[c.king] != piece::make(KING, whiteTurn) || m_squares[c.rook] != piece::make(ROOK, whiteTurn)) continue;
+
+        bool safe = true;
+        for (Bitboard path = c.safe; path && safe;) safe = !isSquareAttacked(bb::popLsb(path), !whiteTurn);
+        if (safe) moves.push(Move(c.king, c.kingTo));
+    }
+}
+
+void chessboard::generateChecks(bool whiteTurn, MoveList& moves) const {
+    SEARCH_STAT(moveGenCalls++);
+    SEARCH_TIMER(moveGenNs);
+    const LegalMasks masks = legalMasks(whiteTurn);
+    const int us = whiteTurn ? 0 : 1;
+    const Bitboard own = m_colors[us];
+    const Bitboard enemy = m_colors[1 - us];
+    const Bitboard promotionRank = whiteTurn ? 0xFFULL : 0xFFULL << 56;
+    const int king = bb::lsb(m_pieces[piece::make(KING, !whiteTurn)]);
+
+    // Squares from which each piece type would attack the enemy king.
+    Bitboard checkSquares[6];
+    checkSquares[PAWN] = bb::ATTACKS.pawn[whiteTurn ? 1 : 0][king];
+    checkSquares[KNIGHT] = bb::ATTACKS.knight[king];
+    checkSquares[BISHOP] = bb::bishopAttacks(king, m_occupied);
+    checkSquares[ROOK] = bb::rookAttacks(king, m_occupied);
+    checkSquares[QUEEN] = checkSquares[BISHOP] | checkSquares[ROOK];
+    checkSquares[KING] = 0;
+
+    // Own pieces that are the only blocker between one of our sliders and
+    // the king, with the ray each one sits on. Leaving that ray discovers check.
+    Bitboard discoverers = 0;
+    Bitboard lines[8] = {};
+    for (int dir = 0; dir < 8; ++dir) {
+        Bitboard blocker = bb::rayAttacks(dir, king, m_occupied) & own;
+        if (!blocker) continue;
+
+        const int diagonal = dir >= bb::NORTH_EAST;
+        Bitboard sliders = m_pieces[piece::make(diagonal ? BISHOP : ROOK, whiteTurn)] | m_pieces[piece::make(QUEEN, whiteTurn)];
+        if (bb::rayAttacks(dir, bb::lsb(blocker), m_occupied) & sliders) {
+            discoverers |= blocker;
+            lines[dir] = bb::ATTACKS.rays[dir][king];
+        }
+    }
+
+    for (int type = PAWN; type <= KING; ++type) {
+        const int code = piece::make(type, whiteTurn);
+        Bitboard pieces = m_pieces[code];
+        while (pieces) {
+            int from = bb::popLsb(pieces);
+            Bitboard targets = legalTargets(masks, code, from, piece::moveTargets(code, from, own, enemy));
+            Bitboard line = 0;
+            if (discoverers & bb::bit(from)) {
+                for (Bitboard l : lines) {
+                    if (l & bb::bit(from)) line = l;
+                }
+            }
+
+            Bitboard promotions = (type == PAWN) ? targets & promotionRank : 0;
+            targets &= (checkSquares[type] | ~line) & ~promotions;
+            if (!line) targets &= checkSquares[type];
+
+            while (targets) {
+                int to = bb::popLsb(targets);
+                moves.push(Move(from, to, 0, (enemy & bb::bit(to)) != 0));
+            }
 
-    return dfs(maxDepth, whiteToMove, sequence);
-}
-
-std::vector<Move> chessboard::generateLegalMoves(bool whiteTurn, bool sortCaptures) {
-    std::vector<Move> moves;
-    for (int r1 = 0; r1 < BOARD_SIZE; ++r1) {
-        for (int c1 = 0; c1 < BOARD_SIZE; ++c1) {
-            auto& p = getElement(r1, c1);
-            if (!p || p->isWhite() != whiteTurn) continue;
-
-            for (int r2 = 0; r2 < BOARD_SIZE; ++r2) {
-                for (int c2 = 0; c2 < BOARD_SIZE; ++c2) {
-                    MoveRecord rec;
-                    
-                    if (this->makeMoveUndo(r1, c1, r2, c2, 'q', rec)) {
-                        Move m{r1, c1, r2, c2, 'q'};
-                        m.capture = (rec.captured != nullptr);
-                        moves.push_back(m);
-                        this->undoMove(rec);
+            // A promotion checks if it uncovers a line or the new piece sees
+            // the king, possibly through the square the pawn just left.
+            while (promotions) {
+                int to = bb::popLsb(promotions);
+                const bool capture = (enemy & bb::bit(to)) != 0;
+                const Bitboard after = (m_occupied & ~bb::bit(from)) | bb::bit(to);
+                const bool discovered = line && !(line & bb::bit(to));
+
+                for (char promo : {'q', 'r', 'b', 'n'}) {
+                    const int promoted = piece::make(piece::type(piece::fromSymbol(promo)), whiteTurn);
+                    if (discovered || (piece::attacks(promoted, to, after) & bb::bit(king))) {
+                        moves.push(Move(from, to, promo, capture));
                     }
                 }
             }
         }
     }
-    if (sortCaptures) {
-        std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) {
-            return a.capture > b.capture;
-        });
+
+    // The special moves are few; generate them and keep the checking ones.
+    // En passant checks with the pawn or by opening a line through either
+    // vacated square. The castling rook is the only piece that can check.
+    MoveList special;
+    generateEnPassant(whiteTurn, special);
+    if (masks.checkMask == ~Bitboard(0)) generateCastling(whiteTurn, special);
+    const Bitboard diagonal = m_pieces[piece::make(BISHOP, whiteTurn)] | m_pieces[piece::make(QUEEN, whiteTurn)];
+    const Bitboard straight = m_pieces[piece::make(ROOK, whiteTurn)] | m_pieces[piece::make(QUEEN, whiteTurn)];
+    for (const Move m : special) {
+        Bitboard after;
+        bool check;
+        if (m.isCapture()) {
+            after = (m_occupied & ~bb::bit(m.from()) & ~bb::bit(m.to() + (whiteTurn ? 8 : -8))) | bb::bit(m.to());
+            check = (bb::ATTACKS.pawn[whiteTurn ? 0 : 1][m.to()] & bb::bit(king)) ||
+                    (bb::bishopAttacks(king, after) & diagonal) || (bb::rookAttacks(king, after) & straight);
+        } else {
+            const CastlingMove& c = *std::find_if(std::begin(CASTLING_MOVES), std::end(CASTLING_MOVES),
+                                                  [&](const CastlingMove& cm) { return cm.kingTo == m.to() && cm.king == m.from(); });
+            after = (m_occupied & ~bb::bit(c.king) & ~bb::bit(c.rook)) | bb::bit(c.kingTo) | bb::bit(c.rookTo);
+            check = (bb::rookAttacks(c.rookTo, after) & bb::bit(king)) != 0;
+        }
+        if (check) moves.push(m);
     }
+}
+
+MoveList chessboard::generateCheckingMoves(bool whiteTurn) const {
+    MoveList moves;
+    generateChecks(whiteTurn, moves);
     return moves;
 }
 
-int chessboard::evaluate() const {
-    int score = 0;
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        for (int j = 0; j < BOARD_SIZE; ++j) {
-            const auto& p = getElement(i, j);
-            if (p) {
-                int val = pieceValue(p->getSymbol());
-                score += p->isWhite() ? val : -val;
-            }
-        }
+MoveList chessboard::generateLegalMoves(bool whiteTurn) const {
+    MoveList moves;
+    generateMoves(whiteTurn, moves);
+    return moves;
+}
+
+std::uint64_t chessboard::perft(int depth, bool whiteTurn, bool bulk) {
+    if (depth == 0) return 1;
+
+    MoveList moves = generateLegalMoves(whiteTurn);
+    if (bulk && depth == 1) return moves.size();
+
+    std::uint64_t nodes = 0;
+    for (const auto& m : moves) {
+        MoveRecord rec;
+        doMove(m, rec);
+        nodes += perft(depth - 1, !whiteTurn, bulk);
+        undoMove(rec);
     }
-    return score;
+    return nodes;
+}
+
+// Tapered between the middlegame and endgame sums kept by putPiece and
+// removePiece. Promotions can push the phase past PHASE_TOTAL.
+int chessboard::evaluate() const {
+    const int phase = std::min(m_phase, PHASE_TOTAL);
+    return (m_mgScore * phase + m_egScore * (PHASE_TOTAL - phase)) / PHASE_TOTAL;
 }
 
 int chessboard::analyze(int depth, int alpha, int beta, bool maximizingPlayer) {
-    if (depth == 0) return evaluate();
+    SEARCH_TIMER(searchNs);
+    prepareSearch();
+    m_control = SearchControl{};
+
+    if (maximizingPlayer) return search(depth, 0, alpha, beta, true);
+    return -search(depth, 0, -beta, -alpha, false);
+}
 
-    std::vector<Move> moves = generateLegalMoves(maximizingPlayer, true);
+// Negamax form of analyze: scores are from the side to move's point of view.
+// PVS: the first move gets the full window, the rest a null window around
+// alpha and a full re-search only if they beat it. Late quiet moves are
+// searched a ply or two shallower first. The null move gives the opponent
+// a free move; if a reduced search still fails high the node is cut.
+int chessboard::search(int depth, int ply, int alpha, int beta, bool whiteTurn, bool allowNull) {
+    if (depth <= 0 || ply >= MAX_PLY) {
+        SEARCH_TIMER(quiescenceNs);
+        return quiescence(alpha, beta, ply, whiteTurn);
+    }
+    if (limitReached()) return 0;
+    SEARCH_STAT(nodes++);
+
+    const std::uint64_t key = positionKey(whiteTurn);
+    const int alphaOrig = alpha;
+    m_path->keys[ply] = key;
+    if (ply > 0 && (m_halfmoveClock >= FIFTY_MOVE_PLIES || isRepetition(key, ply))) return 0;
+
+    TranspositionTable::Entry entry;
+    bool hashHit = m_tt->probe(key, entry);
+    SEARCH_STAT(ttProbes++);
+    if (hashHit) SEARCH_STAT(ttHits++);
+    if (hashHit && entry.depth >= depth && ply > 0) {
+        int score = scoreFromTT(entry.score, ply);
+        if (entry.bound == TranspositionTable::EXACT ||
+            (entry.bound == TranspositionTable::LOWER && score >= beta) ||
+            (entry.bound == TranspositionTable::UPPER && score <= alpha)) {
+            SEARCH_STAT(ttCutoffs++);
+            return score;
+        }
+    }
+
+    const bool inCheck = isCheck(whiteTurn);
+
+    // Zugzwang guard: with only king and pawns left, passing can be the
+    // best move, so the null move would prove nothing.
+    if (m_control.nullMove && allowNull && !inCheck && ply > 0 && depth >= NULL_MOVE_MIN_DEPTH &&
+        beta < MATE_BOUND && hasNonPawnMaterial(whiteTurn) && (whiteTurn ? evaluate() : -evaluate()) >= beta) {
+        const int reduction = depth > NULL_MOVE_DEEP_DEPTH ? NULL_MOVE_DEEP_REDUCTION : NULL_MOVE_REDUCTION;
+        // The pass resets the clock, so repetition checks below it stop
+        // here instead of comparing across it.
+        const int epSquare = m_epSquare;
+        const int halfmoveClock = m_halfmoveClock;
+        setEnPassant(-1);
+        m_halfmoveClock = 0;
+        int score = -search(depth - 1 - reduction, ply + 1, -beta, -beta + 1, !whiteTurn, false);
+        m_halfmoveClock = halfmoveClock;
+        setEnPassant(epSquare);
+        if (m_control.stopped) return 0;
+        if (score >= beta) return score > MATE_BOUND ? beta : score;
+    }
+
+    MoveList moves = generateLegalMoves(whiteTurn);
     if (moves.empty()) {
-        if (isCheck(maximizingPlayer)) return maximizingPlayer ? -100000 : 100000;
+        if (inCheck) return -(MATE_SCORE - ply);
         return 0;
     }
 
-    if (maximizingPlayer) {
-        int maxEval = -1000000;
-        for (const auto& m : moves) {
-            MoveRecord rec;
-            if (makeMoveUndo(m.fromRow, m.fromCol, m.toRow, m.toCol, m.promotion, rec)) {
-                int eval = analyze(depth - 1, alpha, beta, false);
-                undoMove(rec);
-                maxEval = std::max(maxEval, eval);
-                alpha = std::max(alpha, eval);
-                if (beta <= alpha) break;
+    int scores[MoveList::CAPACITY];
+    scoreMoves(moves, scores, hashHit ? entry.move : Move{}, ply, whiteTurn);
+
+    int best = -INFINITE_SCORE;
+    Move bestMove = moves[0];
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        const Move m = moves[i];
+
+        MoveRecord rec;
+        doMove(m, rec);
+
+        int score;
+        if (i == 0) {
+            score = -search(depth - 1, ply + 1, -beta, -alpha, !whiteTurn);
+        } else {
+            // Only quiet moves ordered by history, never killers, checks or
+            // moves out of check. Losing captures carry negative scores,
+            // so they are excluded by kind rather than by score.
+            int reduction = 0;
+            if (m_control.lmr && depth >= LMR_MIN_DEPTH && i >= LMR_MIN_MOVES && !inCheck &&
+                !m.isCapture() && !m.promotion() && scores[i] < KILLER_SCORE - 1 && !isCheck(!whiteTurn)) {
+                reduction = (depth >= 6 && i >= 2 * LMR_MIN_MOVES) ? 2 : 1;
             }
-        }
-        return maxEval;
-    } else {
-        int minEval = 1000000;
-        for (const auto& m : moves) {
-            MoveRecord rec;
-            if (makeMoveUndo(m.fromRow, m.fromCol, m.toRow, m.toCol, m.promotion, rec)) {
-                int eval = analyze(depth - 1, alpha, beta, true);
-                undoMove(rec);
-                minEval = std::min(minEval, eval);
-                beta = std::min(beta, eval);
-                if (beta <= alpha) break;
+
+            const int windowBeta = m_control.pvs ? alpha + 1 : beta;
+            score = -search(depth - 1 - reduction, ply + 1, -windowBeta, -alpha, !whiteTurn);
+            if (score > alpha && (reduction || (m_control.pvs && score < beta))) {
+                score = -search(depth - 1, ply + 1, -beta, -alpha, !whiteTurn);
             }
         }
-        return minEval;
+        undoMove(rec);
+        if (m_control.stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = m;
+        }
+        alpha = std::max(alpha, score);
+        if (beta <= alpha) {
+            ++m_control.betaCutoffs;
+            if (i == 0) ++m_control.firstMoveCutoffs;
+            SEARCH_STAT(cutoffIndex[std::min(i, SearchStats::CUTOFF_BUCKETS - 1)]++);
+            updateOrdering(m, depth, ply, whiteTurn);
+            break;
+        }
     }
+
+    TranspositionTable::Bound bound = TranspositionTable::EXACT;
+    if (best <= alphaOrig) bound = TranspositionTable::UPPER;
+    else if (best >= beta) bound = TranspositionTable::LOWER;
+    m_tt->store(key, depth, scoreToTT(best, ply), bound, bestMove);
+    if (ply == 0) m_control.rootBest = bestMove;
+
+    return best;
+}
+
+bool chessboard::hasNonPawnMaterial(bool white) const {
+    const Bitboard kingAndPawns = m_pieces[piece::make(KING, white)] | m_pieces[piece::make(PAWN, white)];
+    return (m_colors[white ? 0 : 1] & ~kingAndPawns) != 0;
+}
+
+void chessboard::prepareSearch() {
+    if (!m_tt) m_tt = std::make_shared<TranspositionTable>();
+    if (!m_ordering) m_ordering = std::make_unique<MoveOrdering>();
+    if (!m_path) m_path = std::make_unique<SearchPath>();
+}
+
+// hashMove is Move{} when there is none; it never equals a generated move.
+void chessboard::scoreMoves(const MoveList& moves, int* scores, Move hashMove, int ply, bool whiteTurn) const {
+    const int side = whiteTurn ? 0 : 1;
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move m = moves[i];
+
+        if (m == hashMove) scores[i] = HASH_MOVE_SCORE;
+        else if (m.isCapture()) {
+            // Only en passant captures onto an empty square.
+            const char victim = m_squares[m.to()] == NO_PIECE ? 'p' : piece::toSymbol(m_squares[m.to()]);
+            const char attacker = piece::toSymbol(m_squares[m.from()]);
+            // Taking something at least as valuable can never lose material,
+            // so the exchange is only worked out for the other captures.
+            const int exchange = pieceValue(victim) >= pieceValue(attacker) ? 0 : staticExchange(m);
+            scores[i] = exchange < 0 ? exchange : CAPTURE_SCORE + mvvLva(victim, attacker);
+        }
+        else if (m.promotion()) scores[i] = CAPTURE_SCORE + pieceValue(m.promotion());
+        else if (m == m_ordering->killers[ply][0]) scores[i] = KILLER_SCORE;
+        else if (m == m_ordering->killers[ply][1]) scores[i] = KILLER_SCORE - 1;
+        else scores[i] = m_ordering->history[side][m.from()][m.to()];
+    }
+}
+
+void chessboard::updateOrdering(Move m, int depth, int ply, bool whiteTurn) {
+    if (m.isCapture() || m.promotion()) return;
+
+    Move* killers = m_ordering->killers[ply];
+    if (m != killers[0]) {
+        killers[1] = killers[0];
+        killers[0] = m;
+    }
+
+    int& h = m_ordering->history[whiteTurn ? 0 : 1][m.from()][m.to()];
+    h += depth * depth;
+    if (h > HISTORY_LIMIT) {
+        for (auto& side : m_ordering->history)
+            for (auto& row : side)
+                for (auto& value : row) value /= 2;
+    }
+}
+
+// Capture-only search at the leaves so a score is never taken in the
+// middle of an exchange. In check every evasion is searched instead.
+int chessboard::quiescence(int alpha, int beta, int ply, bool whiteTurn) {
+    if (limitReached()) return 0;
+    SEARCH_STAT(qnodes++);
+
+    const int standPat = whiteTurn ? evaluate() : -evaluate();
+    if (ply >= MAX_PLY) return standPat;
+
+    const bool inCheck = isCheck(whiteTurn);
+    int best = -INFINITE_SCORE;
+    if (!inCheck) {
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+        best = standPat;
+    }
+
+    MoveList moves;
+    generateMoves(whiteTurn, moves, !inCheck);
+    if (inCheck && moves.empty()) return -(MATE_SCORE - ply);
+    int scores[MoveList::CAPACITY];
+    scoreMoves(moves, scores, Move{}, ply, whiteTurn);
+
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        const Move m = moves[i];
+        if (!inCheck) {
+            // Losing captures sort last; none of them can raise the stand
+            // pat once the opponent recaptures, so the rest is skipped.
+            if (scores[i] < 0) break;
+            // Delta pruning: even winning the piece outright plus a margin
+            // would not lift the score to alpha. En passant takes a pawn
+            // from beside an empty target square.
+            int gain = 0;
+            if (m.isCapture()) gain = pieceValue(m_squares[m.to()] == NO_PIECE ? 'p' : piece::toSymbol(m_squares[m.to()]));
+            if (m.promotion()) gain += pieceValue(m.promotion()) - pieceValue('p');
+            if (standPat + gain + DELTA_MARGIN <= alpha) continue;
+        }
+
+        MoveRecord rec;
+        doMove(m, rec);
+        int score = -quiescence(-beta, -alpha, ply + 1, !whiteTurn);
+        undoMove(rec);
+        if (m_control.stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            alpha = std::max(alpha, score);
+            if (alpha >= beta) break;
+        }
+    }
+
+    return best;
+}
+
+bool chessboard::limitReached() {
+    if (m_control.stopped) return true;
+    if (m_control.sharedStop && m_control.sharedStop->load(std::memory_order_relaxed)) {
+        m_control.stopped = true;
+        return true;
+    }
+    ++m_control.nodes;
+    // Helpers report in batches so the counter is not contended per node.
+    if (m_control.sharedNodes && (m_control.nodes & (NODE_REPORT_INTERVAL - 1)) == 0) {
+        m_control.sharedNodes->fetch_add(NODE_REPORT_INTERVAL, std::memory_order_relaxed);
+    }
+    if (m_control.nodeLimit && m_control.nodes >= m_control.nodeLimit) m_control.stopped = true;
+    else if (m_control.timed && (m_control.nodes & 1023) == 0 &&
+             std::chrono::steady_clock::now() >= m_control.deadline) m_control.stopped = true;
+    return m_control.stopped;
+}
+
+SearchResult chessboard::iterativeDeepening(bool whiteToMove, const SearchLimits& limits) {
+    SEARCH_TIMER(searchNs);
+    prepareSearch();
+    *m_ordering = MoveOrdering{};
+
+    const auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+    m_control = SearchControl{};
+    m_control.pvs = limits.pvs;
+    m_control.nullMove = limits.nullMove;
+    m_control.lmr = limits.lmr;
+    m_control.gameHistory = limits.history;
+
+    if (generateLegalMoves(whiteToMove).empty()) {
+        int score = isCheck(whiteToMove) ? -MATE_SCORE : 0;
+        result.score = whiteToMove ? score : -score;
+        return result;
+    }
+
+    // Lazy SMP: helpers search the same root on their own copies and only
+    // talk to the main thread through the shared transposition table.
+    // Their node counts are summed in helperNodes as they go, so the
+    // per-iteration reports cover every thread.
+    std::atomic<bool> stopHelpers{false};
+    std::atomic<std::uint64_t> helperNodes{0};
+    const std::size_t helperCount = static_cast<std::size_t>(std::max(limits.threads - 1, 0));
+    std::vector<chessboard> helperBoards;
+    std::vector<std::thread> helpers;
+    helperBoards.reserve(helperCount);
+    for (std::size_t i = 0; i < helperCount; ++i) helperBoards.push_back(*this);
+    for (std::size_t i = 0; i < helperCount; ++i) {
+        helpers.emplace_back([&, i]() {
+            helperBoards[i].searchHelper(whiteToMove, limits, 1 + static_cast<int>(i % 2), stopHelpers, helperNodes);
+        });
+    }
+
+    for (int depth = 1; depth <= limits.maxDepth; ++depth) {
+        if (depth == 2) {
+            m_control.nodeLimit = limits.nodes;
+            m_control.timed = limits.timeMs > 0;
+            m_control.deadline = start + std::chrono::milliseconds(limits.timeMs);
+            m_control.sharedStop = limits.stop;
+        }
+
+        int score = search(depth, 0, -INFINITE_SCORE, INFINITE_SCORE, whiteToMove);
+        if (m_control.stopped) break;
+
+        result.depth = depth;
+        result.score = whiteToMove ? score : -score;
+        result.hasMove = true;
+        result.bestMove = m_control.rootBest;
+
+        SEARCH_STAT(trace.push_back({depth, result.score, m_stats->nodes, m_stats->qnodes, elapsedMs(start), result.bestMove}));
+        if (limits.onIteration) {
+            result.nodes = m_control.nodes + helperNodes.load(std::memory_order_relaxed);
+            result.timeMs = elapsedMs(start);
+            limits.onIteration(result);
+        }
+        if (isMateScore(score)) break;
+    }
+
+    stopHelpers.store(true, std::memory_order_relaxed);
+    for (auto& t : helpers) t.join();
+
+    result.nodes = m_control.nodes + helperNodes.load();
+    result.betaCutoffs = m_control.betaCutoffs;
+    result.firstMoveCutoffs = m_control.firstMoveCutoffs;
+    result.timeMs = elapsedMs(start);
+    m_control = SearchControl{};
+    return result;
+}
+
+void chessboard::searchHelper(bool whiteToMove, const SearchLimits& limits, int startDepth, const std::atomic<bool>& stop,
+                              std::atomic<std::uint64_t>& nodes) {
+    prepareSearch();
+    m_control = SearchControl{};
+    m_control.sharedStop = &stop;
+    m_control.sharedNodes = &nodes;
+    m_control.pvs = limits.pvs;
+    m_control.nullMove = limits.nullMove;
+    m_control.lmr = limits.lmr;
+    m_control.gameHistory = limits.history;
+    for (int depth = startDepth; depth <= limits.maxDepth && !m_control.stopped; ++depth) {
+        search(depth, 0, -INFINITE_SCORE, INFINITE_SCORE, whiteToMove);
+    }
+    nodes.fetch_add(m_control.nodes & (NODE_REPORT_INTERVAL - 1), std::memory_order_relaxed);
 }
 
 void chessboard::initChessboard() {
     clear();
-    setElement(0, 0, createPieceBySymbol('r', 0, 0));
-    setElement(0, 1, createPieceBySymbol('n', 0, 1));
-    setElement(0, 2, createPieceBySymbol('b', 0, 2));
-    setElement(0, 3, createPieceBySymbol('q', 0, 3));
-    setElement(0, 4, createPieceBySymbol('k', 0, 4));
+    const char backRank[] = "rnbqkbnr";
+    for (int j = 0; j < BOARD_SIZE; ++j) {
+        putPiece(piece::fromSymbol(backRank[j]), bb::square(0, j));
+        putPiece(BLACK_PAWN, bb::square(1, j));
+        putPiece(WHITE_PAWN, bb::square(6, j));
+        putPiece(piece::fromSymbol(std::toupper(backRank[j])), bb::square(7, j));
+    }
     blackKingPos = {0, 4};
-    setElement(0, 5, createPieceBySymbol('b', 0, 5));
-    setElement(0, 6, createPieceBySymbol('n', 0, 6));
-    setElement(0, 7, createPieceBySymbol('r', 0, 7));
-    for (int j = 0; j < BOARD_SIZE; ++j) setElement(1, j, createPieceBySymbol('p', 1, j));
-
-    setElement(7, 0, createPieceBySymbol('R', 7, 0));
-    setElement(7, 1, createPieceBySymbol('N', 7, 1));
-    setElement(7, 2, createPieceBySymbol('B', 7, 2));
-    setElement(7, 3, createPieceBySymbol('Q', 7, 3));
-    setElement(7, 4, createPieceBySymbol('K', 7, 4));
     whiteKingPos = {7, 4};
-    setElement(7, 5, createPieceBySymbol('B', 7, 5));
-    setElement(7, 6, createPieceBySymbol('N', 7, 6));
-    setElement(7, 7, createPieceBySymbol('R', 7, 7));
-    for (int j = 0; j < BOARD_SIZE; ++j) setElement(6, j, createPieceBySymbol('P', 6, j));
+    setCastling(ALL_CASTLING);
 }
 
-bool chessboard::isCheck(bool whiteKing) const {
-    
-    position kingPos = whiteKing ? whiteKingPos : blackKingPos;
-    
-    
-    if (kingPos.row == -1 || kingPos.col == -1) return false;
+bool chessboard::loadFEN(const std::string& fen, bool& whiteToMove) {
+    return loadFEN(fen.c_str(), whiteToMove);
+}
 
-    
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        for (int j = 0; j < BOARD_SIZE; ++j) {
-            const auto& p = getElement(i, j);
-            
-            
-            if (p && p->isWhite() != whiteKing) {
-                
-                if (p->isvalidmove(kingPos.row, kingPos.col, *this)) {
-                    return true; 
-                }
+namespace {
+const char* skipSpaces(const char* p) {
+    while (*p == ' ') ++p;
+    return p;
+}
+
+// Non-negative decimal field; leaves value alone when there are no digits.
+const char* parseCounter(const char* p, int& value) {
+    if (*p < '0' || *p > '9') return p;
+    value = 0;
+    while (*p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+    return p;
+}
+}
+
+// Single pass over the string with no allocation. Fields after the
+// placement are optional and default to "w - - 0 1". Castling rights whose
+// king or rook is not at home and an en passant square no pawn can capture
+// on are dropped.
+bool chessboard::loadFEN(const char* fen, bool& whiteToMove) {
+    clear();
+    const char* p = skipSpaces(fen);
+
+    int row = 0, col = 0;
+    for (; *p && *p != ' '; ++p) {
+        if (*p == '/') {
+            if (col != BOARD_SIZE || ++row >= BOARD_SIZE) return false;
+            col = 0;
+        } else if (*p >= '1' && *p <= '8') {
+            col += *p - '0';
+            if (col > BOARD_SIZE) return false;
+        } else {
+            int code = piece::fromSymbol(*p);
+            if (code == NO_PIECE || col >= BOARD_SIZE) return false;
+            putPiece(code, bb::square(row, col++));
+        }
+    }
+    if (row != BOARD_SIZE - 1 || col != BOARD_SIZE) return false;
+    if (bb::popcount(m_pieces[WHITE_KING]) != 1 || bb::popcount(m_pieces[BLACK_KING]) != 1) return false;
+    refreshKingPositions();
+
+    p = skipSpaces(p);
+    whiteToMove = true;
+    if (*p == 'w' || *p == 'b') whiteToMove = (*p++ == 'w');
+    else if (*p) return false;
+
+    p = skipSpaces(p);
+    int rights = 0;
+    for (; *p && *p != ' '; ++p) {
+        switch (*p) {
+            case 'K': rights |= WHITE_OO; break;
+            case 'Q': rights |= WHITE_OOO; break;
+            case 'k': rights |= BLACK_OO; break;
+            case 'q': rights |= BLACK_OOO; break;
+            case '-': break;
+            default: return false;
+        }
+    }
+    const struct { int right, king, rook, kingCode, rookCode; } homes[] = {
+        {WHITE_OO, 60, 63, WHITE_KING, WHITE_ROOK}, {WHITE_OOO, 60, 56, WHITE_KING, WHITE_ROOK},
+        {BLACK_OO, 4, 7, BLACK_KING, BLACK_ROOK}, {BLACK_OOO, 4, 0, BLACK_KING, BLACK_ROOK},
+    };
+    for (const auto& h : homes) {
+        if (m_squares[h.king] != h.kingCode || m_squares[h.rook] != h.rookCode) rights &= ~h.right;
+    }
+    setCastling(rights);
+
+    p = skipSpaces(p);
+    if (*p >= 'a' && *p <= 'h' && (p[1] == '3' || p[1] == '6')) {
+        const int sq = bb::square(8 - (p[1] - '0'), *p - 'a');
+        // The pawn that just moved is the opponent's: its passed square is
+        // on row 5 after a white push, row 2 after a black one.
+        const bool pushedByWhite = bb::rowOf(sq) == 5;
+        if (pushedByWhite != whiteToMove &&
+            (bb::ATTACKS.pawn[pushedByWhite ? 0 : 1][sq] & m_pieces[piece::make(PAWN, whiteToMove)])) {
+            setEnPassant(sq);
+        }
+        p += 2;
+    } else if (*p == '-') {
+        ++p;
+    } else if (*p) {
+        return false;
+    }
+
+    p = parseCounter(skipSpaces(p), m_halfmoveClock);
+    p = parseCounter(skipSpaces(p), m_fullmoveNumber);
+    if (m_fullmoveNumber < 1) m_fullmoveNumber = 1;
+    return true;
+}
+
+std::string chessboard::toFEN(bool whiteToMove) const {
+    std::string fen;
+    fen.reserve(90);
+
+    for (int row = 0; row < BOARD_SIZE; ++row) {
+        int empty = 0;
+        for (int col = 0; col < BOARD_SIZE; ++col) {
+            int code = m_squares[bb::square(row, col)];
+            if (code == NO_PIECE) {
+                ++empty;
+                continue;
             }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += piece::toSymbol(code);
         }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (row < BOARD_SIZE - 1) fen += '/';
     }
+
+    fen += whiteToMove ? " w " : " b ";
+    if (!m_castling) fen += '-';
+    if (m_castling & WHITE_OO) fen += 'K';
+    if (m_castling & WHITE_OOO) fen += 'Q';
+    if (m_castling & BLACK_OO) fen += 'k';
+    if (m_castling & BLACK_OOO) fen += 'q';
+
+    fen += ' ';
+    if (m_epSquare >= 0) {
+        fen += static_cast<char>('a' + bb::colOf(m_epSquare));
+        fen += static_cast<char>('0' + 8 - bb::rowOf(m_epSquare));
+    } else {
+        fen += '-';
+    }
+
+    fen += ' ';
+    fen += std::to_string(m_halfmoveClock);
+    fen += ' ';
+    fen += std::to_string(m_fullmoveNumber);
+    return fen;
+}
+
+bool chessboard::isSquareAttacked(int sq, bool byWhite, Bitboard occupied, Bitboard attackerMask) const {
+    const int offset = byWhite ? 0 : 6;
+    auto theirs = [&](int type) { return m_pieces[offset + type] & attackerMask; };
+
+    // A pawn of the attacking side reaches sq from the squares a pawn of
+    // the other colour would attack from sq.
+    if (bb::ATTACKS.pawn[byWhite ? 1 : 0][sq] & theirs(PAWN)) return true;
+    if (bb::ATTACKS.knight[sq] & theirs(KNIGHT)) return true;
+    if (bb::ATTACKS.king[sq] & theirs(KING)) return true;
+
+    const Bitboard queens = theirs(QUEEN);
+    if (bb::bishopAttacks(sq, occupied) & (theirs(BISHOP) | queens)) return true;
+    if (bb::rookAttacks(sq, occupied) & (theirs(ROOK) | queens)) return true;
     return false;
 }
 
-bool chessboard::isCheckmate(bool whiteTurn) const {
-    
-    if (!isCheck(whiteTurn)) return false;
+Bitboard chessboard::attackersTo(int sq, Bitboard occupied) const {
+    const Bitboard diagonal = m_pieces[WHITE_BISHOP] | m_pieces[BLACK_BISHOP] | m_pieces[WHITE_QUEEN] | m_pieces[BLACK_QUEEN];
+    const Bitboard straight = m_pieces[WHITE_ROOK] | m_pieces[BLACK_ROOK] | m_pieces[WHITE_QUEEN] | m_pieces[BLACK_QUEEN];
 
-    
-    chessboard temp = *this;
-    auto moves = temp.generateLegalMoves(whiteTurn);
-    
-    return moves.empty();
+    return (bb::ATTACKS.pawn[1][sq] & m_pieces[WHITE_PAWN])
+         | (bb::ATTACKS.pawn[0][sq] & m_pieces[BLACK_PAWN])
+         | (bb::ATTACKS.knight[sq] & (m_pieces[WHITE_KNIGHT] | m_pieces[BLACK_KNIGHT]))
+         | (bb::ATTACKS.king[sq] & (m_pieces[WHITE_KING] | m_pieces[BLACK_KING]))
+         | (bb::bishopAttacks(sq, occupied) & diagonal)
+         | (bb::rookAttacks(sq, occupied) & straight);
 }
 
-bool chessboard::isStalemate(bool whiteTurn) const {
-    
-    if (isCheck(whiteTurn)) return false;
+// Swap list: gain[d] is what the side making capture d has won so far if
+// the sequence ends there. Each step takes off the least valuable
+// attacker, which can uncover a slider behind it, and the list is then
+// folded back with each side free to stand pat instead of recapturing.
+int chessboard::staticExchange(Move m) const {
+    const int to = m.to();
+    const Bitboard diagonal = m_pieces[WHITE_BISHOP] | m_pieces[BLACK_BISHOP] | m_pieces[WHITE_QUEEN] | m_pieces[BLACK_QUEEN];
+    const Bitboard straight = m_pieces[WHITE_ROOK] | m_pieces[BLACK_ROOK] | m_pieces[WHITE_QUEEN] | m_pieces[BLACK_QUEEN];
+
+    const int mover = m_squares[m.from()];
+    const int victim = m_squares[to];
+    int gain[32];
+    gain[0] = victim != NO_PIECE ? SEE_VALUE[piece::type(victim)] : (m.isCapture() ? SEE_VALUE[PAWN] : 0);
+    int onSquare = SEE_VALUE[piece::type(mover)];
+    if (m.promotion()) {
+        gain[0] += pieceValue(m.promotion()) - SEE_VALUE[PAWN];
+        onSquare = pieceValue(m.promotion());
+    }
 
-    
-    chessboard temp(*this);
-    auto moves = temp.generateLegalMoves(whiteTurn);
-    
-    return moves.empty(); 
+    Bitboard occupied = m_occupied & ~bb::bit(m.from());
+    if (victim == NO_PIECE && m.isCapture()) occupied &= ~bb::bit(bb::square(m.fromRow(), m.toCol()));
+    Bitboard attackers = attackersTo(to, occupied) & occupied;
+    bool white = !piece::isWhite(mover);
+    int depth = 0;
+
+    while (depth < 31) {
+        const Bitboard mine = attackers & occupancy(white);
+        if (!mine) break;
+
+        int type = PAWN;
+        Bitboard from = 0;
+        for (; type <= KING; ++type) {
+            from = mine & m_pieces[(white ? 0 : 6) + type];
+            if (from) break;
+        }
+        // The king may only take last, with nothing left to take it back.
+        if (type == KING && (attackers & occupancy(!white))) break;
+
+        ++depth;
+        gain[depth] = onSquare - gain[depth - 1];
+
+        onSquare = SEE_VALUE[type];
+        occupied &= ~bb::bit(bb::lsb(from));
+        if (type == PAWN || type == BISHOP || type == QUEEN) attackers |= bb::bishopAttacks(to, occupied) & diagonal;
+        if (type == ROOK || type == QUEEN) attackers |= bb::rookAttacks(to, occupied) & straight;
+        attackers &= occupied;
+        white = !white;
+    }
+
+    while (depth > 0) {
+        --depth;
+        gain[depth] = -std::max(-gain[depth], gain[depth + 1]);
+    }
+    return gain[0];
+}
+
+bool chessboard::isCheck(bool whiteKing) const {
+    SEARCH_STAT(isCheckCalls++);
+    Bitboard kingMask = m_pieces[whiteKing ? WHITE_KING : BLACK_KING];
+    if (!kingMask) return false;
+
+    // Same king the old position-based lookup used: the first one in row-major order.
+    return isSquareAttacked(bb::lsb(kingMask), !whiteKing);
+}
+
+// Legality of a pseudo-legal move worked out on the masks alone: vacate
+// the from square, occupy the target, drop any captured piece and ask
+// whether the king isCheck would look at is then attacked.
+bool chessboard::isLegalMove(int code, int from, int to) const {
+    const bool white = piece::isWhite(code);
+    const Bitboard occupied = (m_occupied & ~bb::bit(from)) | bb::bit(to);
+
+    Bitboard kings = m_pieces[white ? WHITE_KING : BLACK_KING];
+    if (piece::type(code) == KING) kings = (kings & ~bb::bit(from)) | bb::bit(to);
+    if (!kings) return true;
+
+    return !isSquareAttacked(bb::lsb(kings), !white, occupied, ~bb::bit(to));
+}
+
+bool chessboard::hasLegalMove(bool whiteTurn) const {
+    const Bitboard own = occupancy(whiteTurn);
+    const Bitboard enemy = occupancy(!whiteTurn);
+
+    // King moves first: when in check they are the likeliest way out.
+    for (int type = KING; type >= PAWN; --type) {
+        const int code = piece::make(type, whiteTurn);
+        Bitboard pieces = m_pieces[code];
+        while (pieces) {
+            int from = bb::popLsb(pieces);
+            Bitboard targets = piece::moveTargets(code, from, own, enemy);
+            while (targets) {
+                if (isLegalMove(code, from, bb::popLsb(targets))) return true;
+            }
+        }
+    }
+    // Castling is never the only legal move, since the king could stop on
+    // the first square instead; en passant can be.
+    MoveList enPassant;
+    generateEnPassant(whiteTurn, enPassant);
+    return !enPassant.empty();
+}
+
+bool chessboard::isCheckmate(bool whiteTurn) const {
+    return isCheck(whiteTurn) && !hasLegalMove(whiteTurn);
+}
+
+bool chessboard::isStalemate(bool whiteTurn) const {
+    return !isCheck(whiteTurn) && !hasLegalMove(whiteTurn);
 }
 
 void chessboard::printChessboard() const {
@@ -444,18 +1845,24 @@ void chessboard::printChessboard() const {
 }
 
 char chessboard::getPieceSymbol(int row, int col) const {
-    const auto& p = this->getElement(row, col);
-    return p ? p->getSymbol() : '.';
+    return piece::toSymbol(m_squares[bb::square(row, col)]);
 }
 
 bool chessboard::isempty(int row, int col) const {
-    return this->getElement(row, col) == nullptr;
+    return m_squares[bb::square(row, col)] == NO_PIECE;
 }
 
 void chessboard::clear() {
-    for (int i = 0; i < BOARD_SIZE; ++i)
-        for (int j = 0; j < BOARD_SIZE; ++j)
-            this->setElement(i, j, nullptr);
+    std::memset(m_squares, NO_PIECE, sizeof(m_squares));
+    for (auto& mask : m_pieces) mask = 0;
+    m_colors[0] = m_colors[1] = 0;
+    m_occupied = 0;
+    m_key = 0;
+    m_mgScore = m_egScore = m_phase = 0;
+    m_castling = 0;
+    m_epSquare = -1;
+    m_halfmoveClock = 0;
+    m_fullmoveNumber = 1;
     whiteKingPos = {-1,-1};
     blackKingPos = {-1,-1};
 }
\ No newline at end of file
@@ -1,128 +1,321 @@
 #ifndef CHESS_H
 #define CHESS_H
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
-#include "matrix.h"
-
-class piece;
-using PiecePtr = std::unique_ptr<piece>;
+#include <cstdlib>
+#include "bitboard.h"
 
 struct position {
     int row;
     int col;
 };
 
-class piece {
-public:
-    int m_row;
-    int m_col;
-    char m_type;
-    bool m_isWhite;
-    bool m_hasMoved = false;
-
-    piece(int row, int col, char type, bool isWhite);
-    piece(const piece& other);
-    virtual ~piece() = default;
-
-    virtual PiecePtr clone() const = 0;
-    virtual bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const = 0;
-    
-    void setRow(int row) { m_row = row; }
-    void setCol(int col) { m_col = col; }
-    bool hasMoved() const { return m_hasMoved; }
-    void setMoved(bool moved) { m_hasMoved = moved; }
-    char getSymbol() const { return m_type; }
-    bool isWhite() const { return m_isWhite; }
+// Pieces are stored by value, one byte per square: 0-5 are the white
+// pawn..king, 6-11 the black ones, NO_PIECE marks an empty square.
+enum PieceCode : std::uint8_t {
+    WHITE_PAWN, WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN, WHITE_KING,
+    BLACK_PAWN, BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN, BLACK_KING,
+    NO_PIECE
 };
 
-class pawn : public piece {
+enum PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+
+// Move logic dispatched on the piece code (piece.cpp).
+namespace piece {
+int fromSymbol(char symbol);
+char toSymbol(int code);
+inline int type(int code) { return code % 6; }
+inline bool isWhite(int code) { return code < 6; }
+inline int make(int type, bool white) { return white ? type : type + 6; }
+
+// Squares the piece attacks, i.e. where it could capture.
+Bitboard attacks(int code, int sq, Bitboard occupied);
+// Pseudo-legal destinations: attacks minus own pieces, pawn pushes and
+// pawn captures of enemy pieces only.
+Bitboard moveTargets(int code, int sq, Bitboard own, Bitboard enemy);
+}
+
+// Packed into 16 bits: from square 6 | to square 6 | promotion piece 2 |
+// promotion flag 1 | capture flag 1, squares numbered like the bitboards.
+// promotion() is 0 or one of "qrbn". Move{} (from == to) means no move.
+class Move {
 public:
-    pawn(int row, int col, bool isWhite);
-    PiecePtr clone() const override { return std::make_unique<pawn>(*this); }
-    bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const override;
-    ~pawn() override = default;
+    constexpr Move() = default;
+    constexpr Move(int from, int to, char promotion = 0, bool capture = false)
+        : m_data(static_cast<std::uint16_t>(from | to << 6 | promotionBits(promotion) | (capture ? CAPTURE_FLAG : 0))) {}
+
+    constexpr int from() const { return m_data & 0x3F; }
+    constexpr int to() const { return (m_data >> 6) & 0x3F; }
+    constexpr int fromRow() const { return bb::rowOf(from()); }
+    constexpr int fromCol() const { return bb::colOf(from()); }
+    constexpr int toRow() const { return bb::rowOf(to()); }
+    constexpr int toCol() const { return bb::colOf(to()); }
+    constexpr char promotion() const { return (m_data & PROMOTION_FLAG) ? "nbrq"[(m_data >> 12) & 3] : 0; }
+    constexpr bool isCapture() const { return (m_data & CAPTURE_FLAG) != 0; }
+    constexpr bool isNull() const { return from() == to(); }
+
+    constexpr std::uint16_t raw() const { return m_data; }
+    static constexpr Move fromRaw(std::uint16_t data) {
+        Move m;
+        m.m_data = data;
+        return m;
+    }
+
+    constexpr bool operator==(const Move& other) const { return m_data == other.m_data; }
+    constexpr bool operator!=(const Move& other) const { return m_data != other.m_data; }
+
+private:
+    static constexpr std::uint16_t PROMOTION_FLAG = 1 << 14;
+    static constexpr std::uint16_t CAPTURE_FLAG = 1 << 15;
+
+    static constexpr int promotionBits(char promotion) {
+        switch (promotion) {
+            case 'n': case 'N': return PROMOTION_FLAG;
+            case 'b': case 'B': return PROMOTION_FLAG | 1 << 12;
+            case 'r': case 'R': return PROMOTION_FLAG | 2 << 12;
+            case 'q': case 'Q': return PROMOTION_FLAG | 3 << 12;
+            default: return 0;
+        }
+    }
+
+    std::uint16_t m_data = 0;
 };
 
-class bishop : public piece {
+// Fixed-capacity move buffer meant to live on the stack, so generating
+// moves never allocates. 256 is above the 218 moves of the richest legal
+// position.
+class MoveList {
 public:
-    bishop(int row, int col, bool isWhite);
-    PiecePtr clone() const override { return std::make_unique<bishop>(*this); }
-    bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const override;
-    ~bishop() override = default;
+    static constexpr int CAPACITY = 256;
+
+    void push(Move m) { m_moves[m_size++] = m; }
+    void resize(int size) { m_size = size; }
+    void clear() { m_size = 0; }
+    int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    Move& operator[](int i) { return m_moves[i]; }
+    const Move& operator[](int i) const { return m_moves[i]; }
+    Move* begin() { return m_moves; }
+    Move* end() { return m_moves + m_size; }
+    const Move* begin() const { return m_moves; }
+    const Move* end() const { return m_moves + m_size; }
+
+private:
+    Move m_moves[CAPACITY];
+    int m_size = 0;
 };
 
-class knight : public piece {
-public:
-    knight(int row, int col, bool isWhite);
-    PiecePtr clone() const override { return std::make_unique<knight>(*this); }
-    bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const override;
-    ~knight() override = default;
+struct SearchResult {
+    Move bestMove{};
+    bool hasMove = false;
+    int score = 0;
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    int timeMs = 0;
+    // Move ordering quality: how many fail-highs there were and how many of
+    // them came from the first move searched.
+    std::uint64_t betaCutoffs = 0;
+    std::uint64_t firstMoveCutoffs = 0;
 };
 
-class rook : public piece {
-public:
-    rook(int row, int col, bool isWhite);
-    PiecePtr clone() const override { return std::make_unique<rook>(*this); }
-    bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const override;
-    ~rook() override = default;
+// A zero limit means "unbounded". The first iteration always completes so
+// there is a move to return even with a tiny budget.
+// With threads > 1 the extra threads run Lazy SMP helpers on their own
+// board copies; the node budget and the result belong to the main thread,
+// SearchResult::nodes counts all of them.
+// stop lets another thread end the search early, like the other limits.
+// onIteration runs on the searching thread after every completed depth;
+// its nodes count the main thread only.
+// pvs, nullMove and lmr switch the individual search techniques, mainly so
+// they can be compared against each other with perft --bench.
+// history lists the positionKey of each game position before the root,
+// oldest first, so that repeating one of them scores as a draw. It is the
+// caller's and must outlive the search.
+struct SearchLimits {
+    int maxDepth = 64;
+    int timeMs = 0;
+    std::uint64_t nodes = 0;
+    int threads = 1;
+    bool pvs = true;
+    bool nullMove = true;
+    bool lmr = true;
+    const std::atomic<bool>* stop = nullptr;
+    const std::vector<std::uint64_t>* history = nullptr;
+    std::function<void(const SearchResult&)> onIteration;
 };
 
-class queen : public piece {
-public:
-    queen(int row, int col, bool isWhite);
-    PiecePtr clone() const override { return std::make_unique<queen>(*this); }
-    bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const override;
-    ~queen() override = default;
+// Opt-in search counters. They are only collected when the engine is built
+// with CHESS_SEARCH_STATS (CMake option of the same name) and a stats object
+// is attached with chessboard::setStats; otherwise the hooks compile to
+// nothing. Only the board the object is attached to counts, so Lazy SMP
+// helpers are not included.
+struct SearchStats {
+    static constexpr int CUTOFF_BUCKETS = 16;
+
+    struct Iteration {
+        int depth = 0;
+        int score = 0;
+        std::uint64_t nodes = 0;
+        std::uint64_t qnodes = 0;
+        int timeMs = 0;
+        Move bestMove{};
+    };
+
+    std::uint64_t nodes = 0;
+    std::uint64_t qnodes = 0;
+    std::uint64_t mateNodes = 0;
+    std::uint64_t ttProbes = 0;
+    std::uint64_t ttHits = 0;
+    std::uint64_t ttCutoffs = 0;
+    // Index of the move that failed high; the last bucket collects the rest.
+    std::uint64_t cutoffIndex[CUTOFF_BUCKETS] = {};
+    std::uint64_t moveGenCalls = 0;
+    std::uint64_t isCheckCalls = 0;
+    // Wall time per phase in nanoseconds. Quiescence is timed from the
+    // horizon, so it is part of searchNs; moveGenNs overlaps both.
+    std::uint64_t searchNs = 0;
+    std::uint64_t quiescenceNs = 0;
+    std::uint64_t moveGenNs = 0;
+    std::uint64_t mateNs = 0;
+    // One entry per completed iterative deepening depth.
+    std::vector<Iteration> trace;
+
+    static constexpr bool enabled() {
+#ifdef CHESS_SEARCH_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+    void reset() { *this = SearchStats{}; }
+    std::string toJSON() const;
 };
 
-class king : public piece {
+// Coordinate notation, e.g. "e2e4" or "e7e8q".
+std::string moveToString(const Move& m);
+
+class TranspositionTable {
 public:
-    king(int row, int col, bool isWhite);
-    PiecePtr clone() const override { return std::make_unique<king>(*this); }
-    bool isvalidmove(int newRow, int newCol, const Matrix<PiecePtr>& board) const override;
-    ~king() override = default;
-};
+    enum Bound : std::uint8_t { NONE, EXACT, LOWER, UPPER };
+
+    struct Entry {
+        std::uint64_t key = 0;
+        int score = 0;
+        std::int8_t depth = 0;
+        Bound bound = NONE;
+        Move move{};
+
+        bool hasMove() const { return !move.isNull(); }
+    };
+
+    static constexpr std::size_t DEFAULT_SIZE_MB = 16;
+
+    explicit TranspositionTable(std::size_t sizeMB = DEFAULT_SIZE_MB);
+
+    void resize(std::size_t sizeMB);
+    void clear();
+    // Entries stored before the call read as misses afterwards, without
+    // touching the table. Every GENERATIONS calls it is cleared instead, so
+    // an entry can never come back into date.
+    void newGeneration();
+    bool probe(std::uint64_t key, Entry& out) const;
+    void store(std::uint64_t key, int depth, int score, Bound bound, Move best);
+    std::size_t capacity() const { return m_count; }
+
+private:
+    // Lock-free for concurrent searchers: each slot keeps its packed data
+    // and key ^ data, so a torn write from two threads fails the key check
+    // instead of returning a mixed entry.
+    struct Slot {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    static constexpr std::uint64_t GENERATIONS = 1 << 14;
 
-struct Move {
-    int fromRow, fromCol;
-    int toRow, toCol;
-    char promotion = 'q';
-    bool capture = false;
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_count = 0;
+    std::size_t m_mask = 0;
+    std::uint64_t m_generation = 0;
 };
 
-class chessboard : public Matrix<PiecePtr> {
+class MateTable;
+
+// ALL_MOVES proves every forced mate within the depth. CHECKS_ONLY restricts
+// the attacker to checking moves: far smaller trees, but mates that need a
+// quiet attacking move are not found.
+enum class MateSearchMode { ALL_MOVES, CHECKS_ONLY };
+
+class chessboard {
 public:
     static constexpr int BOARD_SIZE = 8;
+    static constexpr int MATE_SCORE = 100000;
+    static constexpr int INFINITE_SCORE = 1000000;
+    static constexpr int MAX_PLY = 128;
     position whiteKingPos;
     position blackKingPos;
 
+    enum CastlingRight : std::uint8_t {
+        WHITE_OO = 1, WHITE_OOO = 2, BLACK_OO = 4, BLACK_OOO = 8, ALL_CASTLING = 15
+    };
+
     struct MoveRecord {
         int fromR, fromC, toR, toC;
-        PiecePtr captured;
-        bool moved;
+        std::uint8_t moving = NO_PIECE;
+        std::uint8_t captured = NO_PIECE;
         bool castling = false;
+        bool enPassant = false;
         int rookFromC, rookToC;
-        bool rookMoved;
         bool promotion = false;
-        char originalType;
         position prevWhiteKing;
         position prevBlackKing;
+        std::uint8_t prevCastling = 0;
+        std::int8_t prevEpSquare = -1;
+        int prevHalfmoveClock = 0;
+        int prevFullmoveNumber = 1;
     };
 
     chessboard();
     chessboard(const chessboard& other);
     chessboard& operator=(const chessboard& other);
-    virtual ~chessboard();
+    ~chessboard() = default;
 
     void initChessboard();
+    // Full FEN: placement, side to move, castling rights, en passant square
+    // and move counters. Returns false, leaving the board unspecified, on a
+    // malformed string. The const char* form parses without allocating.
+    bool loadFEN(const std::string& fen, bool& whiteToMove);
+    bool loadFEN(const char* fen, bool& whiteToMove);
+    std::string toFEN(bool whiteToMove) const;
     void clear();
     void printChessboard() const;
 
     bool isCheckmate(bool whiteTurn) const;
     bool isStalemate(bool whiteTurn) const;
     bool isCheck(bool whiteTurn) const;
+    // Reverse lookup from the square: leaper tables for pawns, knights and
+    // the king, ray scans for sliders. attackerMask restricts which of the
+    // attacking side's pieces count (e.g. to leave out a captured one).
+    bool isSquareAttacked(int sq, bool byWhite) const { return isSquareAttacked(sq, byWhite, m_occupied); }
+    bool isSquareAttacked(int sq, bool byWhite, Bitboard occupied, Bitboard attackerMask = ~Bitboard(0)) const;
+    // Pieces of both colours attacking sq with the given occupancy; callers
+    // mask with occupancy() to pick a side or with occupied to drop captures.
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    // Static exchange evaluation: material the side making the capture
+    // gains, in centipawns, if both sides keep recapturing on the target
+    // with their least valuable attacker and may stop when it suits them.
+    // X-rays behind moved sliders are picked up; pins are not.
+    int staticExchange(Move m) const;
+    // Early-exit query on the board in place: stops at the first legal move.
+    bool hasLegalMove(bool whiteTurn) const;
 
     char getPieceSymbol(int row, int col) const;
     bool isempty(int row, int col) const;
@@ -131,18 +324,158 @@ public:
     bool makeMove(int fromRow, int fromCol, int toRow, int toCol, char promotionPiece = 'q');
     bool makeMoveUndo(int fromRow, int fromCol, int toRow, int toCol, char promotionPiece, MoveRecord& rec);
     void undoMove(MoveRecord& rec);
-    int findMate(int maxDepth, bool whiteToMove, std::vector<Move>& sequence);
-    
-    std::vector<Move> generateLegalMoves(bool whiteTurn, bool sortCaptures = false);
+    // Depth-first proof-number search for a forced mate of at most
+    // maxDepth plies. Returns the mate length in plies, -1 if there is
+    // none, or MATE_UNKNOWN if the node, time or stop limit ran out first,
+    // and fills sequence with the main line. Without a node or time limit
+    // the search stops after DEFAULT_MATE_NODES expansions.
+    static constexpr int MATE_UNKNOWN = -2;
+    static constexpr std::uint64_t DEFAULT_MATE_NODES = 5000000;
+    int findMate(int maxDepth, bool whiteToMove, std::vector<Move>& sequence, MateSearchMode mode = MateSearchMode::ALL_MOVES,
+                 const SearchLimits& limits = SearchLimits{});
+
+    MoveList generateLegalMoves(bool whiteTurn) const;
+    // Legal moves that give check: direct, discovered and checking promotions.
+    MoveList generateCheckingMoves(bool whiteTurn) const;
+    // Leaf count to the given depth. Bulk counting returns the legal move
+    // count at depth 1 instead of making each of those moves.
+    std::uint64_t perft(int depth, bool whiteTurn, bool bulk = true);
+    // O(1): reads the sums maintained as pieces are placed and removed.
     int evaluate() const;
     int analyze(int depth, int alpha, int beta, bool maximizingPlayer);
 
+    // Iterative deepening around analyze; score is from white's point of
+    // view like analyze and evaluate, and comes from the last completed depth.
+    SearchResult iterativeDeepening(bool whiteToMove, const SearchLimits& limits);
+    static bool isMateScore(int score) { return std::abs(score) > MATE_SCORE - 1000; }
+    static int matePlies(int score) { return MATE_SCORE - std::abs(score); }
+
     position getWhiteKingPos() const { return whiteKingPos; }
     position getBlackKingPos() const { return blackKingPos; }
 
+    int pieceAt(int sq) const { return m_squares[sq]; }
+    Bitboard pieces(int code) const { return m_pieces[code]; }
+    Bitboard occupancy(bool white) const { return m_colors[white ? 0 : 1]; }
+    Bitboard occupied() const { return m_occupied; }
+    int castlingRights() const { return m_castling; }
+    // Square behind a pawn that just moved two steps, only while an enemy
+    // pawn could capture there; -1 otherwise.
+    int enPassantSquare() const { return m_epSquare; }
+    int halfmoveClock() const { return m_halfmoveClock; }
+    int fullmoveNumber() const { return m_fullmoveNumber; }
+
+    // Incremental Zobrist key of the placement, castling rights and en
+    // passant file; the side to move is folded in by positionKey since the
+    // board itself does not track it.
+    std::uint64_t zobristKey() const { return m_key; }
+    std::uint64_t positionKey(bool whiteToMove) const;
+    // positionKey after m, with the opponent to move, without making it.
+    std::uint64_t positionKeyAfter(Move m) const;
+
+    // Copies of a board share its table. The default one is allocated on
+    // the first analyze call with DEFAULT_SIZE_MB.
+    void setHashSize(std::size_t sizeMB);
+    void clearHash();
+    // Makes the table forget everything for the searches that follow, at
+    // the cost of a counter bump rather than a clear.
+    void newHashGeneration();
+
+    // Counters keep accumulating across searches until the caller resets
+    // them; pass nullptr to detach. Not copied with the board.
+    void setStats(SearchStats* stats) { m_stats = stats; }
+
 private:
-    static PiecePtr createPieceBySymbol(char symbol, int row, int col);
+    // The position itself is plain data; copying a board copies these and
+    // shares the transposition table, nothing is allocated.
+    std::uint8_t m_squares[64];
+    Bitboard m_pieces[12] = {};
+    Bitboard m_colors[2] = {};
+    Bitboard m_occupied = 0;
+    std::uint64_t m_key = 0;
+    // Incremental evaluation, white-relative: material plus piece-square
+    // sums for both game phases, and the phase itself.
+    int m_mgScore = 0;
+    int m_egScore = 0;
+    int m_phase = 0;
+    std::uint8_t m_castling = 0;
+    std::int8_t m_epSquare = -1;
+    int m_halfmoveClock = 0;
+    int m_fullmoveNumber = 1;
+    std::shared_ptr<TranspositionTable> m_tt;
+
+    struct SearchControl {
+        std::uint64_t nodes = 0;
+        std::uint64_t nodeLimit = 0;
+        std::chrono::steady_clock::time_point deadline{};
+        bool timed = false;
+        bool stopped = false;
+        const std::atomic<bool>* sharedStop = nullptr;
+        std::atomic<std::uint64_t>* sharedNodes = nullptr;
+        Move rootBest{};
+        std::uint64_t betaCutoffs = 0;
+        std::uint64_t firstMoveCutoffs = 0;
+        bool pvs = true;
+        bool nullMove = true;
+        bool lmr = true;
+        const std::vector<std::uint64_t>* gameHistory = nullptr;
+    };
+    SearchControl m_control;
+
+    // Killer moves per ply and butterfly history, owned per board so each
+    // search thread keeps its own. Not copied with the board.
+    struct MoveOrdering {
+        Move killers[MAX_PLY][2];
+        int history[2][64][64];
+    };
+    std::unique_ptr<MoveOrdering> m_ordering;
+    // Position keys along the line being searched, by ply.
+    struct SearchPath {
+        std::uint64_t keys[MAX_PLY];
+    };
+    std::unique_ptr<SearchPath> m_path;
+    SearchStats* m_stats = nullptr;
+
+    // Worked out once per node by the generators: the squares a non-king
+    // move has to land on (all of them, the checker and the line to it, or
+    // none in double check) and the pieces pinned to the king, each with
+    // the line it may still move along.
+    struct LegalMasks {
+        int king = -1;
+        Bitboard checkMask = ~Bitboard(0);
+        Bitboard pinned = 0;
+        Bitboard pinLines[8] = {};
+    };
+
     void refreshKingPositions();
+    // Plays a legal move without testing it; the generators only emit legal ones.
+    void doMove(Move m, MoveRecord& rec);
+    LegalMasks legalMasks(bool whiteTurn) const;
+    Bitboard legalTargets(const LegalMasks& masks, int code, int from, Bitboard targets) const;
+    void generateMoves(bool whiteTurn, MoveList& moves, bool capturesOnly = false) const;
+    void generateChecks(bool whiteTurn, MoveList& moves) const;
+    void generateEnPassant(bool whiteTurn, MoveList& moves) const;
+    void generateCastling(bool whiteTurn, MoveList& moves) const;
+    bool isRepetition(std::uint64_t key, int ply) const;
+    void copyPosition(const chessboard& other);
+    void toggleMasks(int code, int sq);
+    void setCastling(int rights);
+    void setEnPassant(int sq);
+    void putPiece(int code, int sq);
+    int removePiece(int sq);
+    bool isLegalMove(int code, int from, int to) const;
+    void prepareSearch();
+    void scoreMoves(const MoveList& moves, int* scores, Move hashMove, int ply, bool whiteTurn) const;
+    void updateOrdering(Move m, int depth, int ply, bool whiteTurn);
+    int search(int depth, int ply, int alpha, int beta, bool whiteTurn, bool allowNull = true);
+    bool hasNonPawnMaterial(bool white) const;
+    int quiescence(int alpha, int beta, int ply, bool whiteTurn);
+    bool limitReached();
+    void searchHelper(bool whiteToMove, const SearchLimits& limits, int startDepth, const std::atomic<bool>& stop,
+                      std::atomic<std::uint64_t>& nodes);
+    MoveList mateMoves(bool whiteTurn, bool attackerIsWhite, MateSearchMode mode) const;
+    bool mateInOne(bool whiteTurn);
+    void mateSearch(int depth, bool whiteTurn, bool attackerIsWhite, MateSearchMode mode, std::uint32_t thresholdPn, std::uint32_t thresholdDn, MateTable& table);
+    int shortestMate(int maxDepth, bool whiteTurn, bool attackerIsWhite, MateSearchMode mode, MateTable& table);
 };
 
 #endif
\ No newline at end of file
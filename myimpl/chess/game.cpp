@@ -3,9 +3,15 @@
 #include <stdexcept>
 #include <sstream>
 #include <algorithm>
+#include <thread>
 
 Game::Game() {
     board.clear();
+    book.open("book.bin");
+}
+
+Game::~Game() {
+    stopAnalysis();
 }
 
 void Game::loadAllTextures() {
@@ -31,6 +37,9 @@ bool Game::loadFont() {
 
 void Game::runGUI() {
     sf::RenderWindow window(sf::VideoMode(800, 950), "Position Analyzer Pro");
+    // The search has its own thread, so the loop only has to keep pace
+    // with the display.
+    window.setFramerateLimit(60);
     loadAllTextures();
     
     
@@ -38,11 +47,11 @@ void Game::runGUI() {
 
     fontLoaded = loadFont();
 
-    sf::Text evalText;
-    if (fontLoaded) evalText.setFont(font);
-    evalText.setCharacterSize(16);
-    evalText.setFillColor(sf::Color::Cyan);
-    evalText.setPosition(10.f, 820.f);
+    sf::Text evalLabel;
+    if (fontLoaded) evalLabel.setFont(font);
+    evalLabel.setCharacterSize(16);
+    evalLabel.setFillColor(sf::Color::Cyan);
+    evalLabel.setPosition(10.f, 820.f);
 
     
     sf::Text turnText;
@@ -59,7 +68,6 @@ void Game::runGUI() {
 
     
     bool needEvaluation = true;
-    std::string currentEvalString = "Evaluating...";
 
     while (window.isOpen()) {
         sf::Event event;
@@ -99,10 +107,16 @@ void Game::runGUI() {
 
         
         if (needEvaluation) {
-            currentEvalString = evaluatePosition(4);
-            evalText.setString(currentEvalString);
+            startAnalysis();
             needEvaluation = false; 
         }
+        {
+            std::lock_guard<std::mutex> lock(evalMutex);
+            if (evalChanged) {
+                evalLabel.setString(evalText);
+                evalChanged = false;
+            }
+        }
 
         window.clear(sf::Color(30, 30, 30));
         drawBoard(window);
@@ -125,10 +139,11 @@ void Game::runGUI() {
         }
 
         
-        window.draw(evalText);
+        window.draw(evalLabel);
 
         window.display();
     }
+    stopAnalysis();
 }
 
 void Game::highlightSquare(sf::RenderWindow& window, position pos, sf::Color color) {
@@ -179,36 +194,82 @@ void Game::drawBoard(sf::RenderWindow& window) {
     }
 }
 
-std::string Game::evaluatePosition(int searchDepth) {
-    std::ostringstream out;
-    std::vector<Move> seq;
+void Game::startAnalysis(int timeBudgetMs) {
+    stopAnalysis();
 
-    
+    // An edited board can be missing a king, which the search cannot handle.
+    if (!board.pieces(WHITE_KING) || !board.pieces(BLACK_KING)) {
+        publishEval("Place both kings to analyze");
+        return;
+    }
     if (board.isCheckmate(whiteToMove)) {
-        return whiteToMove ? "RESULT: Black Wins by Checkmate!" : "RESULT: White Wins by Checkmate!";
+        publishEval(whiteToMove ? "RESULT: Black Wins by Checkmate!" : "RESULT: White Wins by Checkmate!");
+        return;
     }
     if (board.isStalemate(whiteToMove)) {
-        return "RESULT: Draw by Stalemate (PAT)!";
+        publishEval("RESULT: Draw by Stalemate (PAT)!");
+        return;
     }
 
-    
-    int mateIn = board.findMate(searchDepth, whiteToMove, seq);
-    if (mateIn > 0 && !seq.empty()) {
-        const auto& m = seq[0];
-        char pieceChar = std::toupper(board.getPieceSymbol(m.fromRow, m.fromCol));
-        
-        
-        std::string from = std::string(1, 'a' + m.fromCol) + std::to_string(8 - m.fromRow);
-        std::string to = std::string(1, 'a' + m.toCol) + std::to_string(8 - m.toRow);
-        
-        out << "MATE IN " << mateIn << " (" << pieceChar << from << "-" << to << ") | ";
-        out << (whiteToMove ? "WHITE wins" : "BLACK wins"); 
+    // Book positions are answered from the book, without a search.
+    Move bookMove;
+    if (book.probe(board, whiteToMove, bookMove)) {
+        publishEval("Book: " + moveLabel(board, bookMove) + (whiteToMove ? " | White's turn" : " | Black's turn"));
+        return;
+    }
+
+    publishEval("Evaluating...");
+    cancelSearch = false;
+    searchThread = std::thread([this, position = board, white = whiteToMove, timeBudgetMs]() mutable {
+        SearchLimits limits;
+        limits.timeMs = timeBudgetMs;
+        limits.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        limits.stop = &cancelSearch;
+        // Runs between iterations, when the copy is back at the root position.
+        limits.onIteration = [&](const SearchResult& r) { publishEval(describeResult(position, white, r)); };
+
+        SearchResult result = position.iterativeDeepening(white, limits);
+        if (!cancelSearch && result.hasMove) publishEval(describeResult(position, white, result));
+    });
+}
+
+// Joining before anything new is published means a cancelled search can
+// never overwrite the text of the one that replaced it.
+void Game::stopAnalysis() {
+    cancelSearch = true;
+    if (searchThread.joinable()) searchThread.join();
+}
+
+void Game::publishEval(const std::string& text) {
+    std::lock_guard<std::mutex> lock(evalMutex);
+    evalText = text;
+    evalChanged = true;
+}
+
+// Piece letter and squares, e.g. "Pe2-e4".
+std::string Game::moveLabel(const chessboard& position, Move m) {
+    char pieceChar = std::toupper(position.getPieceSymbol(m.fromRow(), m.fromCol()));
+    std::string from = std::string(1, 'a' + m.fromCol()) + std::to_string(8 - m.fromRow());
+    std::string to = std::string(1, 'a' + m.toCol()) + std::to_string(8 - m.toRow());
+    return pieceChar + from + "-" + to;
+}
+
+std::string Game::describeResult(const chessboard& position, bool whiteToMove, const SearchResult& result) {
+    std::ostringstream out;
+    const std::string move = moveLabel(position, result.bestMove);
+    std::uint64_t nps = result.timeMs > 0 ? result.nodes * 1000 / result.timeMs : result.nodes;
+
+    if (chessboard::isMateScore(result.score)) {
+        int mateIn = (chessboard::matePlies(result.score) + 1) / 2;
+        out << "MATE IN " << mateIn << " (" << move << ") | ";
+        out << (result.score > 0 ? "WHITE wins" : "BLACK wins");
         return out.str();
     }
 
     
-    int score = board.evaluate();
-    out << "Eval: " << (score / 100.0) << (whiteToMove ? " | White's turn" : " | Black's turn");
+    out << "Eval: " << (result.score / 100.0) << " | Best: " << move
+        << " (depth " << result.depth << ", " << nps / 1000 << " kN/s)"
+        << (whiteToMove ? " | White's turn" : " | Black's turn");
     return out.str();
 }
 
@@ -216,13 +277,13 @@ std::string Game::movesToString(const std::vector<Move>& seq, bool startWhite) c
     chessboard temp = board;
     std::ostringstream oss;
     for (const auto& m : seq) {
-        char f = 'a' + m.fromCol;
-        int r = 8 - m.fromRow;
-        char tf = 'a' + m.toCol;
-        int tr = 8 - m.toRow;
+        char f = 'a' + m.fromCol();
+        int r = 8 - m.fromRow();
+        char tf = 'a' + m.toCol();
+        int tr = 8 - m.toRow();
         
-        oss << f << r << (m.capture ? "x" : "-") << tf << tr << " ";
-        temp.makeMove(m.fromRow, m.fromCol, m.toRow, m.toCol, m.promotion);
+        oss << f << r << (m.isCapture() ? "x" : "-") << tf << tr << " ";
+        temp.makeMove(m.fromRow(), m.fromCol(), m.toRow(), m.toCol(), m.promotion());
     }
     return oss.str();
 }
\ No newline at end of file
@@ -1,15 +1,21 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include "book.h"
 #include "chess.h"
+#include <atomic>
 #include <string>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <SFML/Graphics.hpp>
 
 class Game {
 private:
     chessboard board;
+    // Optional: a Polyglot book.bin next to the executable.
+    OpeningBook book;
     sf::Font font;
     bool fontLoaded = false;
     bool whiteToMove = true;
@@ -24,12 +30,26 @@ private:
     void highlightSquare(sf::RenderWindow& window, position pos, sf::Color color);
 
     
-    std::string evaluatePosition(int searchDepth = 4);
+    // Analysis runs on searchThread against a copy of the board. Any edit
+    // restarts it; the previous search is cancelled through cancelSearch.
+    // The worker hands its text to the render loop through evalText.
+    std::thread searchThread;
+    std::atomic<bool> cancelSearch{false};
+    std::mutex evalMutex;
+    std::string evalText;
+    bool evalChanged = false;
+
+    void startAnalysis(int timeBudgetMs = 10000);
+    void stopAnalysis();
+    void publishEval(const std::string& text);
+    static std::string moveLabel(const chessboard& position, Move m);
+    static std::string describeResult(const chessboard& position, bool whiteToMove, const SearchResult& result);
     std::string movesToString(const std::vector<Move>& seq, bool startWhite) const;
 
 public:
     Game();
-    
+    ~Game();
+
     
     void runGUI();
 };
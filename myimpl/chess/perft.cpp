@@ -0,0 +1,183 @@
+#include "chess.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct ReferencePosition {
+    const char* name;
+    const char* fen;
+    std::vector<std::uint64_t> counts;
+};
+
+// Published perft counts (chessprogramming.org "Perft Results"), cut off
+// where a full suite run would take more than a few seconds.
+const std::vector<ReferencePosition> REFERENCE_POSITIONS = {
+    {"start", START_FEN, {20, 400, 8902, 197281, 4865609}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", {48, 2039, 97862, 4085603}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467, 422333, 15833292}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", {46, 2079, 89890, 3894594}},
+    {"promotions", "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", {24, 496, 9483, 182838, 3605103}},
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::uint64_t nodes, double seconds) {
+    std::cout << "nodes " << nodes << "  time " << static_cast<int>(seconds * 1000) << " ms  nps "
+              << static_cast<std::uint64_t>(seconds > 0 ? nodes / seconds : 0) << std::endl;
+}
+
+// Share of beta cutoffs produced by the first move searched: how often
+// move ordering put the refutation first.
+double percent(std::uint64_t part, std::uint64_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+int runSuite(int maxDepth, bool bulk) {
+    int failures = 0;
+    std::uint64_t totalNodes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& ref : REFERENCE_POSITIONS) {
+        chessboard board;
+        bool whiteToMove = true;
+        board.loadFEN(ref.fen, whiteToMove);
+
+        for (int depth = 1; depth <= static_cast<int>(ref.counts.size()) && depth <= maxDepth; ++depth) {
+            std::uint64_t nodes = board.perft(depth, whiteToMove, bulk);
+            std::uint64_t expected = ref.counts[depth - 1];
+            totalNodes += nodes;
+
+            bool ok = nodes == expected;
+            if (!ok) ++failures;
+            std::cout << (ok ? "PASS " : "FAIL ") << ref.name << " depth " << depth << ": " << nodes;
+            if (!ok) std::cout << " (expected " << expected << ")";
+            std::cout << std::endl;
+        }
+    }
+
+    report(totalNodes, secondsSince(start));
+    std::cout << (failures ? "FAILED " : "all passed ") << failures << std::endl;
+    return failures ? 1 : 0;
+}
+
+// Fixed-depth searches over the reference positions, for comparing search
+// switches by node count and speed. With stats, each position's
+// SearchStats follow its line as JSON.
+int runBench(int depth, const SearchLimits& switches, bool stats) {
+    if (stats && !SearchStats::enabled()) {
+        std::cerr << "built without CHESS_SEARCH_STATS; the counters stay zero" << std::endl;
+    }
+    std::uint64_t totalNodes = 0;
+    std::uint64_t totalCutoffs = 0, totalFirstMove = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& ref : REFERENCE_POSITIONS) {
+        chessboard board;
+        bool whiteToMove = true;
+        board.loadFEN(ref.fen, whiteToMove);
+
+        SearchStats searchStats;
+        if (stats) board.setStats(&searchStats);
+        SearchLimits limits = switches;
+        limits.maxDepth = depth;
+        SearchResult r = board.iterativeDeepening(whiteToMove, limits);
+        totalNodes += r.nodes;
+        totalCutoffs += r.betaCutoffs;
+        totalFirstMove += r.firstMoveCutoffs;
+        std::cout << ref.name << ": depth " << r.depth << "  best " << moveToString(r.bestMove)
+                  << "  score " << r.score << "  nodes " << r.nodes << "  time " << r.timeMs << " ms"
+                  << "  first-move cutoffs " << std::fixed << std::setprecision(1) << percent(r.firstMoveCutoffs, r.betaCutoffs) << "%" << std::endl;
+        if (stats) std::cout << searchStats.toJSON() << std::endl;
+    }
+
+    std::cout << "first-move cutoffs " << percent(totalFirstMove, totalCutoffs) << "% of " << totalCutoffs << std::endl;
+    report(totalNodes, secondsSince(start));
+    return 0;
+}
+
+void usage() {
+    std::cout << "usage: perft <depth> [fen] [--divide] [--no-bulk]\n"
+              << "       perft --suite [maxDepth] [--no-bulk]\n"
+              << "       perft --bench [depth] [--no-pvs] [--no-null] [--no-lmr] [--stats]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    bool suite = false;
+    bool bench = false;
+    bool divide = false;
+    bool bulk = true;
+    bool stats = false;
+    SearchLimits switches;
+    std::vector<std::string> positional;
+
+    for (const auto& a : args) {
+        if (a == "--suite") suite = true;
+        else if (a == "--divide") divide = true;
+        else if (a == "--no-bulk") bulk = false;
+        else if (a == "--bench") bench = true;
+        else if (a == "--no-pvs") switches.pvs = false;
+        else if (a == "--no-null") switches.nullMove = false;
+        else if (a == "--no-lmr") switches.lmr = false;
+        else if (a == "--stats") stats = true;
+        else if (a == "-h" || a == "--help") { usage(); return 0; }
+        else positional.push_back(a);
+    }
+
+    if (bench) return runBench(positional.empty() ? 8 : std::atoi(positional[0].c_str()), switches, stats);
+
+    if (suite) {
+        int maxDepth = positional.empty() ? 64 : std::atoi(positional[0].c_str());
+        return runSuite(maxDepth, bulk);
+    }
+
+    if (positional.empty()) {
+        usage();
+        return 1;
+    }
+
+    int depth = std::atoi(positional[0].c_str());
+    std::string fen = positional.size() > 1 ? positional[1] : START_FEN;
+
+    chessboard board;
+    bool whiteToMove = true;
+    if (depth < 1 || !board.loadFEN(fen, whiteToMove)) {
+        usage();
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t total = 0;
+
+    if (divide) {
+        for (const auto& m : board.generateLegalMoves(whiteToMove)) {
+            chessboard::MoveRecord rec;
+            if (!board.makeMoveUndo(m.fromRow(), m.fromCol(), m.toRow(), m.toCol(), m.promotion(), rec)) continue;
+            std::uint64_t nodes = board.perft(depth - 1, !whiteToMove, bulk);
+            board.undoMove(rec);
+
+            std::cout << moveToString(m) << ": " << nodes << std::endl;
+            total += nodes;
+        }
+        std::cout << std::endl;
+    } else {
+        total = board.perft(depth, whiteToMove, bulk);
+    }
+
+    report(total, secondsSince(start));
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include "book.h"
+#include "chess.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Clock time kept back for sending bestmove and for the GUI's own delay.
+constexpr int MOVE_OVERHEAD_MS = 50;
+
+// The search thread prints info and bestmove while the input loop answers
+// isready, so every line goes out under one lock.
+std::mutex outputMutex;
+
+void send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+// UCI scores are from the side to move; the engine's are white-relative.
+std::string scoreString(int score, bool whiteToMove) {
+    int own = whiteToMove ? score : -score;
+    if (chessboard::isMateScore(own)) {
+        int moves = (chessboard::matePlies(own) + 1) / 2;
+        return "mate " + std::to_string(own > 0 ? moves : -moves);
+    }
+    return "cp " + std::to_string(own);
+}
+
+std::string infoLine(const SearchResult& r, bool whiteToMove) {
+    std::ostringstream out;
+    out << "info depth " << r.depth << " score " << scoreString(r.score, whiteToMove)
+        << " nodes " << r.nodes << " time " << r.timeMs
+        << " nps " << (r.timeMs > 0 ? r.nodes * 1000 / r.timeMs : r.nodes);
+    if (r.hasMove) out << " pv " << moveToString(r.bestMove);
+    return out.str();
+}
+
+class UciEngine {
+public:
+    ~UciEngine() { stopSearch(); }
+    void run();
+
+private:
+    chessboard m_board;
+    bool m_whiteToMove = true;
+    // Keys of the positions the moves of the last position command passed
+    // through, for repetition detection during the search.
+    std::vector<std::uint64_t> m_gameHistory;
+    std::thread m_search;
+    std::atomic<bool> m_stop{false};
+    // Threads and the search switches set through setoption.
+    SearchLimits m_options;
+    OpeningBook m_book;
+    std::string m_bookFile;
+    void openBook();
+
+    void setOption(std::istringstream& in);
+    void position(std::istringstream& in);
+    void go(std::istringstream& in);
+    void stopSearch();
+    bool playMove(const std::string& text);
+};
+
+void UciEngine::run() {
+    bool white = true;
+    m_board.loadFEN(START_FEN, white);
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+
+        if (command == "uci") {
+            send("id name Code_Academy chess");
+            send("id author Code_Academy");
+            send("option name Hash type spin default " + std::to_string(TranspositionTable::DEFAULT_SIZE_MB) + " min 1 max 4096");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("option name PVS type check default true");
+            send("option name NullMove type check default true");
+            send("option name LMR type check default true");
+            send("option name BookFile type string default <empty>");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "setoption") {
+            stopSearch();
+            setOption(in);
+        } else if (command == "ucinewgame") {
+            stopSearch();
+            m_board.clearHash();
+        } else if (command == "position") {
+            stopSearch();
+            position(in);
+        } else if (command == "go") {
+            stopSearch();
+            go(in);
+        } else if (command == "stop") {
+            stopSearch();
+        } else if (command == "quit") {
+            break;
+        }
+    }
+}
+
+// setoption name <id> [value <x>]
+void UciEngine::setOption(std::istringstream& in) {
+    std::string token, name, value;
+    in >> token;
+    if (token != "name") return;
+    while (in >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    // The rest of the line, so file paths may contain spaces.
+    std::getline(in >> std::ws, value);
+
+    const bool on = value == "true";
+    if (name == "Hash") m_board.setHashSize(std::max(1, std::atoi(value.c_str())));
+    else if (name == "Threads") m_options.threads = std::max(1, std::atoi(value.c_str()));
+    else if (name == "PVS") m_options.pvs = on;
+    else if (name == "NullMove") m_options.nullMove = on;
+    else if (name == "LMR") m_options.lmr = on;
+    else if (name == "BookFile") {
+        m_bookFile = value == "<empty>" ? "" : value;
+        openBook();
+    }
+    else send("info string unknown option " + name);
+}
+
+void UciEngine::openBook() {
+    m_book.close();
+    if (m_bookFile.empty()) return;
+    if (m_book.open(m_bookFile)) send("info string book " + m_bookFile + " entries " + std::to_string(m_book.size()));
+    else send("info string cannot open book " + m_bookFile);
+}
+
+// position startpos|fen <fen> [moves <m1> <m2> ...]
+void UciEngine::position(std::istringstream& in) {
+    std::string token, fen;
+    in >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        in >> token;
+    } else if (token == "fen") {
+        while (in >> token && token != "moves") fen += token + " ";
+    } else {
+        return;
+    }
+
+    m_gameHistory.clear();
+    if (!m_board.loadFEN(fen, m_whiteToMove)) {
+        send("info string invalid fen");
+        return;
+    }
+    if (token != "moves") return;
+
+    while (in >> token) {
+        if (!playMove(token)) {
+            send("info string illegal move " + token);
+            return;
+        }
+    }
+}
+
+bool UciEngine::playMove(const std::string& text) {
+    for (const auto& m : m_board.generateLegalMoves(m_whiteToMove)) {
+        if (moveToString(m) != text) continue;
+        m_gameHistory.push_back(m_board.positionKey(m_whiteToMove));
+        m_board.makeMove(m.fromRow(), m.fromCol(), m.toRow(), m.toCol(), m.promotion());
+        m_whiteToMove = !m_whiteToMove;
+        return true;
+    }
+    return false;
+}
+
+// go [depth n] [movetime ms] [nodes n] [infinite] [wtime/btime/winc/binc/movestogo]
+void UciEngine::go(std::istringstream& in) {
+    SearchLimits limits = m_options;
+    bool infinite = false;
+    int clock = 0, increment = 0, movesToGo = 30;
+
+    std::string token;
+    while (in >> token) {
+        if (token == "depth") in >> limits.maxDepth;
+        else if (token == "movetime") in >> limits.timeMs;
+        else if (token == "nodes") in >> limits.nodes;
+        else if (token == "infinite") infinite = true;
+        else if (token == (m_whiteToMove ? "wtime" : "btime")) in >> clock;
+        else if (token == (m_whiteToMove ? "winc" : "binc")) in >> increment;
+        else if (token == "movestogo") in >> movesToGo;
+    }
+    if (clock > 0 && limits.timeMs == 0) {
+        // The increment only arrives after the move, so it cannot extend
+        // the budget past what is on the clock.
+        const int budget = clock / std::max(movesToGo, 1) + increment / 2;
+        limits.timeMs = std::max(1, std::min(budget, clock - MOVE_OVERHEAD_MS));
+    }
+    if (limits.maxDepth > chessboard::MAX_PLY - 1) limits.maxDepth = chessboard::MAX_PLY - 1;
+
+    const bool white = m_whiteToMove;
+    // A book move is answered straight away, without searching.
+    Move bookMove;
+    if (!infinite && m_book.probe(m_board, white, bookMove)) {
+        send("info string book move");
+        send("bestmove " + moveToString(bookMove));
+        return;
+    }
+
+    m_stop = false;
+    limits.stop = &m_stop;
+    limits.history = &m_gameHistory;
+
+    m_search = std::thread([this, limits, infinite, white]() mutable {
+        std::uint64_t reported = 0;
+        limits.onIteration = [&](const SearchResult& r) {
+            send(infoLine(r, white));
+            reported = r.nodes;
+        };
+
+        // The final totals include the helper threads and any unfinished
+        // iteration; only print them if they add something.
+        SearchResult result = m_board.iterativeDeepening(white, limits);
+        if (result.nodes != reported) send(infoLine(result, white));
+
+        // In infinite mode bestmove may only follow a stop.
+        while (infinite && !m_stop) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        send("bestmove " + (result.hasMove ? moveToString(result.bestMove) : std::string("0000")));
+    });
+}
+
+void UciEngine::stopSearch() {
+    m_stop = true;
+    if (m_search.joinable()) m_search.join();
+}
+
+}
+
+int main() {
+    std::ios::sync_with_stdio(false);
+    UciEngine engine;
+    engine.run();
+    return 0;
+}